@@ -3,7 +3,9 @@
 #include <zf3_game.h>
 #include <zf3_window.h>
 #include <zf3_assets.h>
+#include <zf3_ring_buf.h>
 #include <zf3_renderer.h>
+#include <zf3_particles.h>
 #include <zf3_audio.h>
 #include <zf3_rand.h>
 #include <zf3_misc.h>
@@ -6,10 +6,28 @@
 #include <zf3_misc.h>
 
 namespace zf3 {
+    constexpr int gk_texArrayLimit = 32;
+    constexpr int gk_texAtlasLimit = 16;
+    constexpr Pt2D gk_texAtlasSize = {1024, 1024};
+    constexpr int gk_assetsFilePathBufSize = 256;
+
     struct Textures {
         int cnt;
-        GLID glIDs[gk_texLimit];
         Pt2D sizes[gk_texLimit];
+
+        // Where the pixel data of each texture is on the GPU. Textures packed into an atlas or loaded into a texture array share a GL texture with others, at an offset or in a layer.
+        GLID glIDs[gk_texLimit];
+        Pt2D glTexSizes[gk_texLimit];
+        Pt2D glTexOffsets[gk_texLimit];
+        int glTexLayers[gk_texLimit];
+
+        bool opaque[gk_texLimit]; // Whether every pixel of each texture is fully opaque, so that sprites of it can be drawn without blending.
+
+        bool inArrays; // Whether the GL textures are texture arrays.
+
+        int uniqueGLIDCnt;
+        GLID uniqueGLIDs[gk_texLimit];
+        int uniqueGLIDIndices[gk_texLimit]; // The index into uniqueGLIDs of the GL texture of each texture.
     };
 
     struct Fonts {
@@ -31,13 +49,15 @@ namespace zf3 {
     };
 
     struct Assets {
+        char filePath[gk_assetsFilePathBufSize]; // Kept so that music can be streamed from the file during play.
+
         Textures textures;
         Fonts fonts;
         Sounds sounds;
         Music music;
     };
 
-    bool load_assets();
+    bool load_assets(const bool texArrays = false, const int atlasTexSizeLimit = 0, const char* const filePath = gk_assetsFileName);
     void unload_assets();
     const Assets& get_assets();
 }
@@ -27,6 +27,9 @@ namespace zf3 {
         const char* windowTitle;
         bool windowResizable;
         bool hideCursor;
+
+        bool texArrays; // Load textures into texture arrays, so that sprite batches are not broken by the texture unit limit.
+        int atlasTexSizeLimit; // Textures with neither dimension exceeding this are packed into shared atlases at load time. Zero disables atlasing.
     };
 
     void start_game(const UserGameInfo& userInfo);
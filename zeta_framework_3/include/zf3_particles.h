@@ -0,0 +1,45 @@
+#pragma once
+
+#include <assert.h>
+#include <zf3c.h>
+#include <zf3_renderer.h>
+
+namespace zf3 {
+    constexpr int gk_particleArrayAlignment = 16; // Matches what the allocator guarantees for the arena buffer, so enough for 4-wide vector loads and stores.
+
+    // Particles sharing a texture, source rectangle, origin and scale, with each of their properties kept in its own array so that updates run as simple loops over contiguous floats.
+    struct ParticleSystem {
+        int texIndex;
+        Rect srcRect;
+        Vec2D origin;
+        Vec2D scale;
+
+        int cap;
+        int cnt;
+
+        float* posXs;
+        float* posYs;
+        float* velXs;
+        float* velYs;
+        float* rots;
+        float* rotVels;
+        float* alphas;
+        float* alphaVels;
+        int* lifetimes; // Ticks left before despawning.
+    };
+
+    struct ParticleSpawnInfo {
+        Vec2D pos;
+        Vec2D vel;
+        float rot;
+        float rotVel;
+        float alpha = 1.0f;
+        float alphaVel; // Added to alpha every tick, with the particle despawned once alpha reaches 0.
+        int lifetime;
+    };
+
+    bool init_particle_system(ParticleSystem& sys, MemArena& memArena, const int cap, const int texIndex, const Rect& srcRect, const Vec2D origin = {0.5f, 0.5f}, const Vec2D scale = {1.0f, 1.0f});
+    bool spawn_particle(ParticleSystem& sys, const ParticleSpawnInfo& info);
+    void update_particle_system(ParticleSystem& sys);
+    bool write_particle_system_to_batch(Renderer& renderer, const int layerIndex, const ParticleSystem& sys, const int depth = 0);
+}
@@ -1,18 +1,27 @@
 #pragma once
 
+#include <stddef.h>
 #include <zf3c.h>
 #include <zf3_window.h>
 #include <zf3_assets.h>
 #include <zf3_shader_progs.h>
+#include <zf3_ring_buf.h>
 #include <zf3_misc.h>
 
 namespace zf3 {
     constexpr int gk_renderLayerLimit = 32;
-    constexpr int gk_renderLayerSpriteBatchLimit = 256;
-    constexpr int gk_renderLayerCharBatchLimit = 256;
+    constexpr int gk_renderLayerCharBatchLimit = 256; // Bound by the size of the batch properties array of the character shader.
     constexpr int gk_spriteBatchSlotLimit = 4096;
     constexpr int gk_charBatchSlotLimit = 1024;
-    constexpr int gk_texUnitLimit = 16;
+    constexpr int gk_charBatchBufMinSlotCnt = 16;
+    constexpr int gk_charBatchBufSizeClassCnt = 7; // Slot counts in powers of two from gk_charBatchBufMinSlotCnt up to gk_charBatchSlotLimit.
+    constexpr int gk_charBatchBufPoolFreeLimit = 64;
+    constexpr int gk_renderLayerSpriteCmdLimit = 65536;
+    constexpr int gk_spriteDepthLimit = 65536;
+    constexpr int gk_glUniformCacheLimit = 32;
+    constexpr int gk_glUniformCacheValSizeLimit = sizeof(float) * 16;
+    constexpr int gk_vertRingBufRegionSize = megabytes_to_bytes(16);
+    constexpr int gk_tilemapChunkSize = 32; // The width and height of tilemap chunks in tiles.
 
     enum FontHorAlign {
         FONT_HOR_ALIGN_LEFT,
@@ -39,13 +48,85 @@ namespace zf3 {
     struct QuadBuf {
         GLID vertArrayGLID;
         GLID vertBufGLID;
-        GLID elemBufGLID;
+    };
+
+    // The compact per-sprite record written in instanced mode, which the vertex shader expands into a quad.
+    struct SpriteBatchInst {
+        Vec2D pos;
+        Vec2D size;
+        Vec2D origin;
+        float rot;
+        float alpha;
+        unsigned short texCoords[4]; // Normalised top-left and bottom-right texture coordinates.
+        int texUnit; // Also holds the texture array layer if textures are loaded into arrays.
+    };
+
+    // A sprite recorded by a deferred layer, written to a batch once the layer has been sorted.
+    struct SpriteCmd {
+        unsigned int sortKey; // Depth in the upper 16 bits, GL texture in the lower 16.
+        int texIndex;
+        Vec2D pos;
+        Rect srcRect;
+        Vec2D origin;
+        float rot;
+        Vec2D scale;
+        float alpha;
+    };
+
+    // A sprite to be written by write_sprites_to_batch, defaulting the same as the arguments of write_to_sprite_batch.
+    struct SpriteInstance {
+        int texIndex;
+        Vec2D pos;
+        Rect srcRect;
+        Vec2D origin = {0.5f, 0.5f};
+        float rot = 0.0f;
+        Vec2D scale = {1.0f, 1.0f};
+        float alpha = 1.0f;
+    };
+
+    // Sprites sharing a texture, source rectangle, origin and scale, with the rest of their properties in separate arrays as particle systems store them.
+    struct SpriteArrays {
+        int texIndex;
+        Rect srcRect;
+        Vec2D origin;
+        Vec2D scale;
+
+        const float* posXs;
+        const float* posYs;
+        const float* rots;
+        const float* alphas;
+        int cnt;
     };
 
     struct SpriteBatchTransData {
         int slotsUsed;
-        int texUnitTexIDs[gk_texUnitLimit];
+        GLID texUnitGLIDs[gk_texUnitLimit];
         int texUnitsInUse;
+
+        // Whether any sprite in the batch is rotated, or is translucent by alpha or its texture, which rule out the cheaper shader program variants.
+        bool rotated;
+        bool translucent;
+
+        RingBufRange streamedRange; // Where the batch was last streamed into the vertex ring buffer. As batches are only added to until emptied, which clears this, a range of the current size holds what is in the batch.
+    };
+
+    struct TilemapChunk {
+        QuadBuf quadBuf;
+        int slotsUsed; // Only tiles that are set take up a slot.
+        bool dirty; // Indicates whether tiles in the chunk have been set since its vertex data was last built.
+    };
+
+    // A grid of tiles cut from one texture used as a tileset, numbered left to right then top to bottom. The grid is split into chunks whose vertex data is built once and only rebuilt when one of their tiles is set. On camera layers only the chunks in view are drawn.
+    struct Tilemap {
+        int texIndex;
+        Pt2D tileSize;
+        Pt2D size; // In tiles.
+        Vec2D pos;
+
+        int* tiles; // The tileset index of each tile, or -1 for no tile.
+
+        TilemapChunk* chunks;
+        Pt2D chunkCnts;
     };
 
     struct CharBatchDisplayProps {
@@ -55,24 +136,117 @@ namespace zf3 {
         Color blend;
     };
 
+    // The display properties of a character batch as read by the character shader, laid out to match its std140 uniform block.
+    struct CharBatchShaderProps {
+        Vec2D pos;
+        float rot;
+        float padding;
+        Color blend;
+    };
+
     struct CharBatch {
         QuadBuf quadBuf;
+        int bufSizeClass;
         int slotCnt;
+        int slotsUsed;
+        float* slotVerts; // A copy of the vertex data in the buffer, which writes are compared against so that only changed slots are uploaded.
+        unsigned int textHash; // A hash of the text, font and alignment last written, or 0 if the batch is clear.
+        char* text; // The text last written, which follows the vertex data copy in the same allocation.
+        int textFontIndex;
+        FontHorAlign textHorAlign;
+        FontVerAlign textVerAlign;
+        int mergedFontIndex; // The font the slots were grouped under when last copied into the merged buffer of the layer.
         CharBatchDisplayProps displayProps;
     };
 
+    // Recycles the GPU buffers of deactivated character batches, bucketed by slot count size class.
+    struct CharBatchBufPool {
+        QuadBuf freeBufs[gk_charBatchBufSizeClassCnt][gk_charBatchBufPoolFreeLimit];
+        float* freeBufSlotVerts[gk_charBatchBufSizeClassCnt][gk_charBatchBufPoolFreeLimit];
+        int freeBufCnts[gk_charBatchBufSizeClassCnt];
+
+        int inUseBufCnts[gk_charBatchBufSizeClassCnt];
+        int inUseBufHighWaterMarks[gk_charBatchBufSizeClassCnt]; // The most buffers of each size class in use at once.
+        int freeBufHighWaterMarks[gk_charBatchBufSizeClassCnt];
+        int bufGenCnt; // How many buffers have had to be generated rather than taken from the pool.
+    };
+
     struct CharBatchID {
         int layerIndex;
         int batchIndex;
     };
 
     struct RenderLayer {
-        QuadBuf spriteBatchQuadBufs[gk_renderLayerSpriteBatchLimit];
-        SpriteBatchTransData spriteBatchTransDatas[gk_renderLayerSpriteBatchLimit];
+        Tilemap tilemap; // Drawn beneath the sprites of the layer, if the layer has been given one with init_layer_tilemap.
+
+        bool instanced; // Whether sprites are submitted as one instance record each rather than as four vertices. Must be set before anything is written to the layer.
+
+        // The sprite batch arrays are allocated on the first write to the layer and grown as batches are added, so there is no limit on batches.
+        Byte** spriteBatchSlots; // CPU-side vertex or instance data for each batch, streamed into the vertex ring buffer all at once in render_all if changed since last streamed.
+        int* spriteBatchSlotCaps; // How many slots each batch has memory for, grown as they fill up to gk_spriteBatchSlotLimit.
+        SpriteBatchTransData* spriteBatchTransDatas;
         int spriteBatchesFilled;
         int spriteBatchCnt;
-        CharBatch charBatches[gk_renderLayerCharBatchLimit];
+        int spriteBatchCap;
+
+        bool retained; // Whether the sprites of the layer are kept across ticks, left alone by empty_sprite_batches and only uploaded again once the layer is emptied with empty_sprite_layer and rewritten. Sprites are not culled, as the camera may move onto them later.
+        bool retainedSpritesDirty; // Indicates whether sprites have been written since the batches were last uploaded to the retained buffer.
+        GLID retainedVertArrayGLID;
+        GLID retainedVertBufGLID;
+        int retainedVertBufSize;
+
+        // Sprite counts since the batches were last emptied. Sprites written to camera layers are culled if their bounds are outside the camera view.
+        int culledSpriteCnt;
+        int drawnSpriteCnt;
+
+        bool deferred; // Whether sprites are recorded as commands and sorted by depth then texture before being written to batches in render_all. Sprites of equal depth and GL texture keep their submission order.
+        SpriteCmd* spriteCmds; // Grown as needed up to gk_renderLayerSpriteCmdLimit.
+        int spriteCmdCnt;
+        int spriteCmdCap;
+
+        // The character batch arrays are grown as batches are activated, up to gk_renderLayerCharBatchLimit.
+        CharBatch* charBatches;
+        CharBatchShaderProps* charBatchShaderProps; // What was last uploaded to the properties uniform buffer.
+        int charBatchCap;
         StaticBitset<gk_renderLayerCharBatchLimit> charBatchActivity;
+        GLID charBatchPropsUniBufGLID;
+
+        bool charBatchesMerged; // Whether the character batches are copied into one buffer grouped by font, so that all text in the layer sharing a font is drawn in a single call.
+        bool mergedCharsDirty; // Indicates whether character batch slots have been written or released since the last merge.
+        QuadBuf mergedCharQuadBuf;
+        int mergedCharQuadBufSlotCnt;
+        int mergedCharFontSlotBegins[gk_fontLimit];
+        int mergedCharFontSlotCnts[gk_fontLimit];
+    };
+
+    // Bytes of memory held by a render layer.
+    struct RenderLayerMemUsage {
+        int spriteBatchBytes; // Slot data and bookkeeping of the sprite batches, plus recorded sprite commands.
+        int charBatchBytes; // CPU-side copies of the vertex data of the character batches, plus bookkeeping.
+        int tilemapBytes;
+        int glBufBytes; // GL buffers belonging to the layer alone, which are retained sprites, character batches, merged characters and tilemap chunks.
+    };
+
+    struct GLUniformCacheEntry {
+        GLID progGLID;
+        int loc;
+        Byte val[gk_glUniformCacheValSizeLimit];
+    };
+
+    // Tracks the GL state set in render_all so that calls which would change nothing can be skipped. Bindings are treated as unknown at the start of each frame since other code binds freely, while uniform values carry over as only render_all sets them.
+    struct GLStateCache {
+        GLID progGLID;
+        GLID vertArrayGLID;
+        int activeTexUnit;
+        GLID texUnitGLIDs[gk_texUnitLimit];
+        int blendEnabled; // -1 if unknown.
+
+        GLUniformCacheEntry uniforms[gk_glUniformCacheLimit];
+        int uniformCnt;
+
+        // Counts of the calls made through the cache in the last frame.
+        int issuedCallCnt;
+        int skippedCallCnt;
     };
 
     struct Camera {
@@ -87,20 +261,48 @@ namespace zf3 {
 
         Color bgColor;
         Camera cam;
+
+        GLID spriteUnitQuadVertBufGLID; // Used by the instanced sprite vertex array.
+        GLID quadElemBufGLID; // Shared by the sprite vertex array and the vertex arrays of all character batches.
+
+        GLID matricesUniBufGLID;
+        ShaderProgMatrices matrices; // What was last uploaded to the matrices uniform buffer.
+
+        RingBuf vertRingBuf; // Sprite batch data is streamed through this each frame, as are character batch updates before being copied into their buffers.
+        GLID spriteVertArrayGLID; // Reads sprite vertices from the ring buffer, each batch drawn from where it was written by base vertex.
+        GLID spriteInstVertArrayGLID; // Reads sprite instances from the ring buffer, each batch drawn from where it was written by base instance.
+
+        CharBatchBufPool charBatchBufPool;
+
+        GLStateCache glStateCache;
     };
 
     void clean_renderer(Renderer& renderer);
-    void reset_renderer(Renderer& renderer, const int layerCnt, const int camLayerCnt = 0, const Color bgColor = {}, const Vec2D camPos = {}, const float camScale = 2.0f);
-    void render_all(const Renderer& renderer, const ShaderProgs& shaderProgs);
+    bool reset_renderer(Renderer& renderer, const int layerCnt, const int camLayerCnt = 0, const Color bgColor = {}, const Vec2D camPos = {}, const float camScale = 2.0f);
+    bool render_all(Renderer& renderer, const ShaderProgs& shaderProgs);
+    RenderLayerMemUsage get_render_layer_mem_usage(const Renderer& renderer, const int layerIndex);
 
     void empty_sprite_batches(Renderer& renderer);
-    void write_to_sprite_batch(Renderer& renderer, const int layerIndex, const int texIndex, const Vec2D pos, const Rect& srcRect, const Vec2D origin = {0.5f, 0.5f}, const float rot = 0.0f, const Vec2D scale = {1.0f, 1.0f}, const float alpha = 1.0f);
+    void empty_sprite_layer(Renderer& renderer, const int layerIndex);
+    bool write_to_sprite_batch(Renderer& renderer, const int layerIndex, const int texIndex, const Vec2D pos, const Rect& srcRect, const Vec2D origin = {0.5f, 0.5f}, const float rot = 0.0f, const Vec2D scale = {1.0f, 1.0f}, const float alpha = 1.0f, const int depth = 0);
+    bool write_sprites_to_batch(Renderer& renderer, const int layerIndex, const SpriteInstance* const sprites, const int cnt, const int depth = 0);
+    bool write_sprite_arrays_to_batch(Renderer& renderer, const int layerIndex, const SpriteArrays& sprites, const int depth = 0);
 
-    CharBatchID activate_any_char_batch(Renderer& renderer, const int layerIndex, const int slotCnt, const int fontIndex, const Vec2D pos);
+    bool init_layer_tilemap(Renderer& renderer, const int layerIndex, const int texIndex, const Pt2D size, const Pt2D tileSize, const Vec2D pos = {});
+    void set_tilemap_tile(Renderer& renderer, const int layerIndex, const Pt2D tilePos, const int tileIndex);
+
+    bool activate_any_char_batch(Renderer& renderer, const int layerIndex, const int slotCnt, const int fontIndex, const Vec2D pos, CharBatchID& id);
     void deactivate_char_batch(Renderer& renderer, const CharBatchID id);
-    void write_to_char_batch(Renderer& renderer, const CharBatchID id, const char* const text, const FontHorAlign horAlign, const FontVerAlign verAlign);
-    void clear_char_batch(const Renderer& renderer, const CharBatchID id);
+    bool write_to_char_batch(Renderer& renderer, const CharBatchID id, const char* const text, const FontHorAlign horAlign, const FontVerAlign verAlign);
+    void clear_char_batch(Renderer& renderer, const CharBatchID id);
+
+    inline int get_tilemap_tile(const Renderer& renderer, const int layerIndex, const Pt2D tilePos) {
+        const Tilemap& tilemap = renderer.layers[layerIndex].tilemap;
+        assert(tilePos.x >= 0 && tilePos.x < tilemap.size.x && tilePos.y >= 0 && tilePos.y < tilemap.size.y);
+        return tilemap.tiles[(tilePos.y * tilemap.size.x) + tilePos.x];
+    }
 
+    // The reference points into the character batch array of the layer, which is reallocated as it grows, so it must not be held across a call to activate_any_char_batch.
     inline CharBatchDisplayProps& get_char_batch_display_props(Renderer& renderer, const CharBatchID id) {
         return renderer.layers[id.layerIndex].charBatches[id.batchIndex].displayProps;
     }
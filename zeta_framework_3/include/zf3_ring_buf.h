@@ -0,0 +1,38 @@
+#pragma once
+
+#include <assert.h>
+#include <string.h>
+#include <zf3c.h>
+#include <zf3_window.h>
+#include <zf3_misc.h>
+
+namespace zf3 {
+    constexpr int gk_ringBufRegionCnt = 3;
+
+    // A GL buffer streamed into front to back and wrapped around, split into regions which are each guarded by a fence placed after the frame that last wrote to them. Writing into a region waits only for the GPU to finish reading what was there, which with three regions is the frame before last.
+    struct RingBuf {
+        GLID glID;
+        int size;
+        int regionSize;
+
+        Byte* persistentPtr; // The buffer mapped for its whole lifetime, if buffer storage is supported. Otherwise writes go through glBufferSubData.
+
+        int head;
+        int lap; // Incremented each time writing wraps around to the start.
+        GLsync regionFences[gk_ringBufRegionCnt];
+        int regionsWritten; // A bitmask of the regions written since fences were last placed.
+    };
+
+    // Where data was written to a ring buffer, kept so that it can be drawn from again while nothing has been written over it.
+    struct RingBufRange {
+        int offs;
+        int size; // 0 if nothing has been written.
+        int lap;
+    };
+
+    bool init_ring_buf(RingBuf& ring, const int regionSize);
+    void clean_ring_buf(RingBuf& ring);
+    bool write_to_ring_buf(RingBuf& ring, RingBufRange& range, const void* const data, const int size, const int align);
+    bool reuse_ring_buf_range(RingBuf& ring, const RingBufRange& range);
+    void fence_ring_buf(RingBuf& ring);
+}
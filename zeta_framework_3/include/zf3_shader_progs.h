@@ -7,29 +7,75 @@
 
 namespace zf3 {
     constexpr int gk_spriteQuadShaderProgVertCnt = 11;
-    constexpr int gk_charQuadShaderProgVertCnt = 4;
+    constexpr int gk_charQuadShaderProgVertCnt = 5;
+    constexpr int gk_texUnitLimit = 16; // The length of the textures array in the sprite shaders, and so how many texture units a sprite batch can use.
+    constexpr int gk_charQuadShaderProgBatchLimit = 256; // The length of the batch properties array in the character shader.
+    constexpr int gk_charQuadShaderProgBatchPropsBinding = 0; // The uniform buffer binding point of the batch properties block.
+    constexpr int gk_shaderProgMatricesBinding = 1; // The uniform buffer binding point of the matrices block, which every program shares.
+
+    // Sprite programs come in variants indexed by a combination of these flags, each compiled with the work its flags make unneeded left out.
+    constexpr int gk_spriteQuadShaderProgNoRotFlag = 1 << 0; // For sprites which are all unrotated.
+    constexpr int gk_spriteQuadShaderProgOpaqueFlag = 1 << 1; // For sprites which are all fully opaque, which are drawn with blending disabled.
+    constexpr int gk_spriteQuadShaderProgVariantCnt = 4;
+
+    // The views in the matrices block, which programs pick between by index.
+    constexpr int gk_shaderProgCamViewIndex = 0;
+    constexpr int gk_shaderProgDefaultViewIndex = 1;
+    constexpr int gk_shaderProgViewCnt = 2;
+
+    // Matches the std140 layout of the matrices block.
+    struct ShaderProgMatrices {
+        Matrix4x4 proj;
+        Matrix4x4 views[gk_shaderProgViewCnt];
+    };
+
+    static_assert(sizeof(ShaderProgMatrices) == 64 * (1 + gk_shaderProgViewCnt));
 
     struct SpriteQuadShaderProg {
         GLID glID;
-        int projUniLoc;
-        int viewUniLoc;
+        int viewIndexUniLoc;
         int texturesUniLoc;
     };
 
     struct CharQuadShaderProg {
         GLID glID;
-        int projUniLoc;
-        int viewUniLoc;
-        int posUniLoc;
-        int rotUniLoc;
-        int blendUniLoc;
+        int viewIndexUniLoc;
     };
 
     struct ShaderProgs {
-        SpriteQuadShaderProg spriteQuad;
+        SpriteQuadShaderProg spriteQuad[gk_spriteQuadShaderProgVariantCnt];
+        SpriteQuadShaderProg spriteQuadInst[gk_spriteQuadShaderProgVariantCnt];
         CharQuadShaderProg charQuad;
     };
 
-    ShaderProgs load_shader_progs();
+    // A program submitted for compiling and linking, which the driver may still be working on in the background until it is completed.
+    struct PendingShaderProg {
+        GLID glID;
+        GLID vertShaderGLID;
+        GLID fragShaderGLID;
+
+        const char* name;
+        unsigned long long binaryCacheKey;
+        int vertShaderSrcLen; // These and the source hash are recorded in the binary cache file along with the key.
+        int fragShaderSrcLen;
+        unsigned int srcHash;
+        bool fromBinaryCache;
+
+        double submitDur; // Seconds spent on the main thread submitting the program.
+    };
+
+    struct PendingShaderProgs {
+        PendingShaderProg spriteQuad[gk_spriteQuadShaderProgVariantCnt];
+        PendingShaderProg spriteQuadInst[gk_spriteQuadShaderProgVariantCnt];
+        PendingShaderProg charQuad;
+
+        bool parallel; // Whether the driver is compiling and linking in the background.
+        bool useBinaryCache;
+    };
+
+    // Shader programs are created in two phases so that other loading can be done while the driver compiles, which with KHR_parallel_shader_compile happens on its own threads.
+    PendingShaderProgs submit_shader_progs(const bool texArrays);
+    bool complete_shader_progs(ShaderProgs& progs, PendingShaderProgs& pendingProgs);
+    void abandon_shader_progs(PendingShaderProgs& pendingProgs);
     void unload_shader_progs(ShaderProgs& progs);
 }
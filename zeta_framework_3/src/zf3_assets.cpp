@@ -1,11 +1,576 @@
 #include <zf3_assets.h>
 
+#include <limits.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace zf3 {
     static Assets* i_assets;
 
-    bool load_assets() {
+    // The assets file mapped read-only into memory, or the data of a single asset within it, read front to back. Asset data is handed to GL and AL straight from the mapping rather than being copied out first.
+    struct AssetsFileReader {
+        const Byte* data;
+        int size;
+        int pos;
+        bool overran; // Set if a read would have gone past the end of the data, which is then treated as corrupt.
+    };
+
+    // The table of contents of the assets file, through which any asset can be found without reading the others.
+    struct AssetsFileTOC {
+        AssetsFileTOCEntry entries[gk_assetsFileTOCEntryLimit];
+        int typeBeginIndexes[ASSET_TYPE_CNT]; // Where the entries of each asset type begin in the table.
+        int typeCnts[ASSET_TYPE_CNT];
+    };
+
+    static constexpr int ik_assetTypeLimits[ASSET_TYPE_CNT] = {gk_texLimit, gk_fontLimit, gk_soundLimit, gk_musicLimit};
+
+    static constexpr int ik_texAtlasPadding = 1; // Space left between packed textures, so that sampling at their edges never picks up a neighbour.
+    static constexpr int ik_texAtlasSkylineSegLimit = gk_texAtlasSize.x + 1;
+
+    // A horizontal segment of the skyline formed by the tops of the textures packed so far.
+    struct TexAtlasSkylineSeg {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct TexAtlasPacker {
+        TexAtlasSkylineSeg* segs;
+        int segCnt;
+    };
+
+    static bool map_assets_file(AssetsFileReader& reader, const char* const filePath) {
+        assert(is_zero(reader));
+
+#ifdef _WIN32
+        const HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart > INT_MAX) {
+            CloseHandle(fileHandle);
+            return false;
+        }
+
+        const HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(fileHandle); // The mapping keeps the file open.
+
+        if (!mappingHandle) {
+            return false;
+        }
+
+        const void* const data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mappingHandle); // The view keeps the mapping alive.
+
+        if (!data) {
+            return false;
+        }
+
+        reader.size = static_cast<int>(fileSize.QuadPart);
+#else
+        const int fd = open(filePath, O_RDONLY);
+
+        if (fd == -1) {
+            return false;
+        }
+
+        struct stat fileStat;
+
+        if (fstat(fd, &fileStat) == -1 || fileStat.st_size == 0 || fileStat.st_size > INT_MAX) {
+            close(fd);
+            return false;
+        }
+
+        void* const data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps the file open.
+
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+
+        reader.size = static_cast<int>(fileStat.st_size);
+#endif
+
+        reader.data = static_cast<const Byte*>(data);
+
+        return true;
+    }
+
+    static void unmap_assets_file(AssetsFileReader& reader) {
+#ifdef _WIN32
+        UnmapViewOfFile(reader.data);
+#else
+        munmap(const_cast<Byte*>(reader.data), reader.size);
+#endif
+
+        zero_out(reader);
+    }
+
+    // Returns a pointer to the next bytes of the file and moves past them, or nullptr if the file ends first.
+    static const Byte* read_assets_file_bytes(AssetsFileReader& reader, const int size) {
+        if (reader.overran || size < 0 || size > reader.size - reader.pos) {
+            reader.overran = true;
+            return nullptr;
+        }
+
+        const Byte* const bytes = reader.data + reader.pos;
+        reader.pos += size;
+        return bytes;
+    }
+
+    // Copies out a value, which may be unaligned in the file. The value is zeroed if the file ends first.
+    template<typename T>
+    static void read_assets_file_val(AssetsFileReader& reader, T& val) {
+        const Byte* const bytes = read_assets_file_bytes(reader, sizeof(T));
+
+        if (bytes) {
+            memcpy(&val, bytes, sizeof(T));
+        } else {
+            zero_out(val);
+        }
+    }
+
+    // Checks that every entry lies within the file and that the entries are grouped by type, and finds where each group begins.
+    static bool index_assets_file_toc(AssetsFileTOC& toc, const int entryCnt, const int fileSize) {
+        for (int i = 0; i < ASSET_TYPE_CNT; ++i) {
+            toc.typeBeginIndexes[i] = entryCnt;
+            toc.typeCnts[i] = 0;
+        }
+
+        for (int i = 0; i < entryCnt; ++i) {
+            const AssetsFileTOCEntry& entry = toc.entries[i];
+
+            if (entry.type < 0 || entry.type >= ASSET_TYPE_CNT || (i > 0 && entry.type < toc.entries[i - 1].type)) {
+                return false;
+            }
+
+            if (entry.offs < static_cast<int>(sizeof(AssetsFileHeader)) || entry.size < 0 || entry.size > fileSize - entry.offs) {
+                return false;
+            }
+
+            if (toc.typeCnts[entry.type] == ik_assetTypeLimits[entry.type]) {
+                return false;
+            }
+
+            if (toc.typeCnts[entry.type] == 0) {
+                toc.typeBeginIndexes[entry.type] = i;
+            }
+
+            ++toc.typeCnts[entry.type];
+        }
+
+        return true;
+    }
+
+    // Reads the header and table of contents. Files written for a different version of the format are rejected rather than misread.
+    static bool read_assets_file_toc(AssetsFileTOC& toc, AssetsFileReader& reader, const char* const filePath) {
+        AssetsFileHeader header;
+        read_assets_file_val(reader, header);
+
+        if (reader.overran || header.magic != gk_assetsFileMagic) {
+            log_error("\"%s\" is not an assets file!", filePath);
+            return false;
+        }
+
+        if (header.version != gk_assetsFileVersion) {
+            log_error("\"%s\" has format version %d, but version %d is required! The assets need repacking.", filePath, header.version, gk_assetsFileVersion);
+            return false;
+        }
+
+        if (header.tocEntryCnt >= 0 && header.tocEntryCnt <= gk_assetsFileTOCEntryLimit && header.tocOffs >= static_cast<int>(sizeof(header))) {
+            reader.pos = header.tocOffs;
+
+            const Byte* const entries = read_assets_file_bytes(reader, sizeof(*toc.entries) * header.tocEntryCnt);
+
+            if (entries) {
+                memcpy(toc.entries, entries, sizeof(*toc.entries) * header.tocEntryCnt);
+
+                if (index_assets_file_toc(toc, header.tocEntryCnt, reader.size)) {
+                    return true;
+                }
+            }
+        }
+
+        log_error("\"%s\" has a corrupt table of contents!", filePath);
+        return false;
+    }
+
+    static const AssetsFileTOCEntry& get_assets_file_toc_entry(const AssetsFileTOC& toc, const AssetType type, const int index) {
+        assert(index >= 0 && index < toc.typeCnts[type]);
+        return toc.entries[toc.typeBeginIndexes[type] + index];
+    }
+
+    // Returns a reader over only the data of the given asset. The table of contents has already been checked to lie within the file.
+    static AssetsFileReader get_asset_reader(const AssetsFileReader& fileReader, const AssetsFileTOCEntry& entry) {
+        return {
+            .data = fileReader.data + entry.offs,
+            .size = entry.size,
+            .pos = 0,
+            .overran = false
+        };
+    }
+
+    // Whether the asset data was read exactly, with nothing missing or left over.
+    static bool was_asset_read_exactly(const AssetsFileReader& assetReader) {
+        return !assetReader.overran && assetReader.pos == assetReader.size;
+    }
+
+    static bool init_tex_atlas_packer(TexAtlasPacker& packer, MemArena& memArena) {
+        packer.segs = push_to_mem_arena<TexAtlasSkylineSeg>(memArena, ik_texAtlasSkylineSegLimit);
+
+        if (!packer.segs) {
+            return false;
+        }
+
+        packer.segs[0] = {0, 0, gk_texAtlasSize.x};
+        packer.segCnt = 1;
+
+        return true;
+    }
+
+    // Returns the lowest y at which a rectangle of the given size can rest on the skyline with its left edge at the start of the given segment, or -1 if it cannot fit there.
+    static int calc_tex_atlas_skyline_fit_y(const TexAtlasPacker& packer, const int segIndex, const Pt2D size) {
+        if (packer.segs[segIndex].x + size.x > gk_texAtlasSize.x) {
+            return -1;
+        }
+
+        int y = 0;
+        int widthLeft = size.x;
+
+        for (int i = segIndex; widthLeft > 0; ++i) {
+            y = max(y, packer.segs[i].y);
+
+            if (y + size.y > gk_texAtlasSize.y) {
+                return -1;
+            }
+
+            widthLeft -= packer.segs[i].width;
+        }
+
+        return y;
+    }
+
+    static void remove_tex_atlas_skyline_seg(TexAtlasPacker& packer, const int index) {
+        for (int i = index; i < packer.segCnt - 1; ++i) {
+            packer.segs[i] = packer.segs[i + 1];
+        }
+
+        --packer.segCnt;
+    }
+
+    // Places the rectangle using the bottom-left skyline heuristic, returning false if it does not fit.
+    static bool pack_into_tex_atlas(TexAtlasPacker& packer, const Pt2D size, Pt2D& pos) {
+        int bestSegIndex = -1;
+        int bestY = 0;
+
+        for (int i = 0; i < packer.segCnt; ++i) {
+            const int y = calc_tex_atlas_skyline_fit_y(packer, i, size);
+
+            if (y != -1 && (bestSegIndex == -1 || y < bestY)) {
+                bestSegIndex = i;
+                bestY = y;
+            }
+        }
+
+        if (bestSegIndex == -1) {
+            return false;
+        }
+
+        pos = {packer.segs[bestSegIndex].x, bestY};
+
+        // Insert a segment for the top of the rectangle.
+        assert(packer.segCnt < ik_texAtlasSkylineSegLimit);
+
+        for (int i = packer.segCnt; i > bestSegIndex; --i) {
+            packer.segs[i] = packer.segs[i - 1];
+        }
+
+        packer.segs[bestSegIndex] = {pos.x, pos.y + size.y, size.x};
+        ++packer.segCnt;
+
+        // Shrink or remove the segments now underneath it.
+        const int right = pos.x + size.x;
+
+        while (bestSegIndex + 1 < packer.segCnt && packer.segs[bestSegIndex + 1].x < right) {
+            TexAtlasSkylineSeg& seg = packer.segs[bestSegIndex + 1];
+            const int overlap = right - seg.x;
+
+            if (seg.width <= overlap) {
+                remove_tex_atlas_skyline_seg(packer, bestSegIndex + 1);
+                continue;
+            }
+
+            seg.x += overlap;
+            seg.width -= overlap;
+            break;
+        }
+
+        // Merge neighbouring segments at the same height.
+        for (int i = 0; i < packer.segCnt - 1;) {
+            if (packer.segs[i].y == packer.segs[i + 1].y) {
+                packer.segs[i].width += packer.segs[i + 1].width;
+                remove_tex_atlas_skyline_seg(packer, i + 1);
+            } else {
+                ++i;
+            }
+        }
+
+        return true;
+    }
+
+    // Packs textures with both dimensions within the limit into atlases, tallest first. Each texture is assigned a surface, being either an atlas or a surface of its own.
+    static bool pack_textures_into_atlases(const Textures& textures, const int atlasTexSizeLimit, MemArena& scratchSpace, int* const texSurfIndices, Pt2D* const texSurfOffsets, Pt2D* const surfSizes, int& surfCnt) {
+        assert(atlasTexSizeLimit + ik_texAtlasPadding <= gk_texAtlasSize.x && atlasTexSizeLimit + ik_texAtlasPadding <= gk_texAtlasSize.y); // Checked by load_assets.
+
+        // Sort the candidate textures by height, descending.
+        int texIndexesSorted[gk_texLimit];
+        int texIndexesSortedCnt = 0;
+
+        for (int i = 0; i < textures.cnt; ++i) {
+            if (textures.sizes[i].x > atlasTexSizeLimit || textures.sizes[i].y > atlasTexSizeLimit) {
+                continue;
+            }
+
+            int j = texIndexesSortedCnt;
+
+            while (j > 0 && textures.sizes[texIndexesSorted[j - 1]].y < textures.sizes[i].y) {
+                texIndexesSorted[j] = texIndexesSorted[j - 1];
+                --j;
+            }
+
+            texIndexesSorted[j] = i;
+            ++texIndexesSortedCnt;
+        }
+
+        // Pack them, opening new atlases as needed. Textures that cannot fit in any atlas are left as separate surfaces.
+        TexAtlasPacker packers[gk_texAtlasLimit];
+        int atlasSurfIndexes[gk_texAtlasLimit];
+        int atlasCnt = 0;
+
+        for (int i = 0; i < texIndexesSortedCnt; ++i) {
+            const int texIndex = texIndexesSorted[i];
+            const Pt2D paddedSize = {textures.sizes[texIndex].x + ik_texAtlasPadding, textures.sizes[texIndex].y + ik_texAtlasPadding};
+
+            for (int j = 0; j <= atlasCnt; ++j) {
+                if (j == atlasCnt) {
+                    if (atlasCnt == gk_texAtlasLimit) {
+                        break;
+                    }
+
+                    if (!init_tex_atlas_packer(packers[atlasCnt], scratchSpace)) {
+                        log_error("Failed to reserve texture atlas packing space!");
+                        return false;
+                    }
+
+                    atlasSurfIndexes[atlasCnt] = surfCnt;
+                    surfSizes[surfCnt] = gk_texAtlasSize;
+                    ++surfCnt;
+                    ++atlasCnt;
+                }
+
+                if (pack_into_tex_atlas(packers[j], paddedSize, texSurfOffsets[texIndex])) {
+                    texSurfIndices[texIndex] = atlasSurfIndexes[j];
+                    break;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static int add_tex_array_layer(Pt2D* const arraySizes, int* const arrayLayerCnts, int& arrayCnt, const Pt2D layerSize) {
+        for (int i = 0; i < arrayCnt; ++i) {
+            if (arraySizes[i].x == layerSize.x && arraySizes[i].y == layerSize.y) {
+                return i;
+            }
+        }
+
+        if (arrayCnt == gk_texArrayLimit) {
+            return -1;
+        }
+
+        arraySizes[arrayCnt] = layerSize;
+        arrayLayerCnts[arrayCnt] = 0;
+
+        return arrayCnt++;
+    }
+
+    // Loads the textures section of the assets file. Textures are first assigned to surfaces (a standalone texture or an atlas of packed ones), which then become either individual GL textures or layers of texture arrays holding surfaces padded to the same power-of-two size.
+    static bool load_textures(Textures& textures, const AssetsFileReader& fileReader, const AssetsFileTOC& toc, const bool texArrays, const int atlasTexSizeLimit) {
+        textures.cnt = toc.typeCnts[ASSET_TYPE_TEXTURE];
+
+        if (textures.cnt == 0) {
+            return true;
+        }
+
+        // Read all texture sizes, recording where the pixel data of each texture is so that it can be uploaded once the GL textures exist.
+        const Byte* pxDatas[gk_texLimit];
+
+        for (int i = 0; i < textures.cnt; ++i) {
+            const AssetsFileTOCEntry& entry = get_assets_file_toc_entry(toc, ASSET_TYPE_TEXTURE, i);
+            AssetsFileReader reader = get_asset_reader(fileReader, entry);
+
+            read_assets_file_val(reader, textures.sizes[i]);
+
+            if (textures.sizes[i].x <= 0 || textures.sizes[i].y <= 0 || textures.sizes[i].x > reader.size / gk_texChannelCnt / textures.sizes[i].y) {
+                return false;
+            }
+
+            pxDatas[i] = read_assets_file_bytes(reader, gk_texChannelCnt * textures.sizes[i].x * textures.sizes[i].y);
+
+            if (!was_asset_read_exactly(reader)) {
+                return false;
+            }
+
+            textures.opaque[i] = entry.flags & gk_texAssetOpaqueFlag;
+        }
+
+        // Assign textures to surfaces.
+        int texSurfIndices[gk_texLimit];
+        Pt2D texSurfOffsets[gk_texLimit] = {};
+        Pt2D surfSizes[gk_texLimit];
+        int surfCnt = 0;
+
+        for (int i = 0; i < textures.cnt; ++i) {
+            texSurfIndices[i] = -1;
+        }
+
+        if (atlasTexSizeLimit > 0) {
+            // Only the skyline segments of the atlas packers need working space.
+            MemArena scratchSpace = {};
+
+            if (!init_mem_arena(scratchSpace, (sizeof(TexAtlasSkylineSeg) * ik_texAtlasSkylineSegLimit + alignof(TexAtlasSkylineSeg)) * gk_texAtlasLimit)) {
+                log_error("Failed to initialise scratch space for texture atlas packing!");
+                return false;
+            }
+
+            const bool packed = pack_textures_into_atlases(textures, atlasTexSizeLimit, scratchSpace, texSurfIndices, texSurfOffsets, surfSizes, surfCnt);
+
+            clean_mem_arena(scratchSpace);
+
+            if (!packed) {
+                return false;
+            }
+        }
+
+        for (int i = 0; i < textures.cnt; ++i) {
+            if (texSurfIndices[i] == -1) {
+                texSurfIndices[i] = surfCnt;
+                surfSizes[surfCnt] = textures.sizes[i];
+                ++surfCnt;
+            }
+        }
+
+        // Create GL textures for the surfaces.
+        GLID surfGLIDs[gk_texLimit];
+        Pt2D surfGLTexSizes[gk_texLimit];
+        int surfLayers[gk_texLimit] = {};
+        int surfUniqueGLIDIndices[gk_texLimit];
+
+        if (texArrays) {
+            Pt2D arraySizes[gk_texArrayLimit];
+            int arrayLayerCnts[gk_texArrayLimit];
+            int arrayIndexes[gk_texLimit];
+            int arrayCnt = 0;
+
+            for (int i = 0; i < surfCnt; ++i) {
+                const Pt2D layerSize = {ceil_to_power_of_two(surfSizes[i].x), ceil_to_power_of_two(surfSizes[i].y)};
+                arrayIndexes[i] = add_tex_array_layer(arraySizes, arrayLayerCnts, arrayCnt, layerSize);
+
+                if (arrayIndexes[i] == -1) {
+                    log_error("Textures require more than %d texture arrays!", gk_texArrayLimit);
+                    return false;
+                }
+
+                surfLayers[i] = arrayLayerCnts[arrayIndexes[i]];
+                ++arrayLayerCnts[arrayIndexes[i]];
+            }
+
+            glGenTextures(arrayCnt, textures.uniqueGLIDs);
+            textures.uniqueGLIDCnt = arrayCnt;
+
+            for (int i = 0; i < arrayCnt; ++i) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, textures.uniqueGLIDs[i]);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, arraySizes[i].x, arraySizes[i].y, arrayLayerCnts[i]);
+            }
+
+            for (int i = 0; i < surfCnt; ++i) {
+                surfGLIDs[i] = textures.uniqueGLIDs[arrayIndexes[i]];
+                surfUniqueGLIDIndices[i] = arrayIndexes[i];
+                surfGLTexSizes[i] = arraySizes[arrayIndexes[i]];
+            }
+
+            textures.inArrays = true;
+        } else {
+            glGenTextures(surfCnt, textures.uniqueGLIDs);
+            textures.uniqueGLIDCnt = surfCnt;
+
+            for (int i = 0; i < surfCnt; ++i) {
+                glBindTexture(GL_TEXTURE_2D, textures.uniqueGLIDs[i]);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, surfSizes[i].x, surfSizes[i].y);
+
+                surfGLIDs[i] = textures.uniqueGLIDs[i];
+                surfUniqueGLIDIndices[i] = i;
+                surfGLTexSizes[i] = surfSizes[i];
+            }
+        }
+
+        // Upload the pixel data of each texture to where it belongs.
+        for (int i = 0; i < textures.cnt; ++i) {
+            const int surfIndex = texSurfIndices[i];
+
+            textures.glIDs[i] = surfGLIDs[surfIndex];
+            textures.glTexSizes[i] = surfGLTexSizes[surfIndex];
+            textures.glTexOffsets[i] = texSurfOffsets[i];
+            textures.glTexLayers[i] = surfLayers[surfIndex];
+            textures.uniqueGLIDIndices[i] = surfUniqueGLIDIndices[surfIndex];
+
+            const Byte* const pxData = pxDatas[i];
+
+            if (textures.inArrays) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, textures.glIDs[i]);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, textures.glTexOffsets[i].x, textures.glTexOffsets[i].y, textures.glTexLayers[i], textures.sizes[i].x, textures.sizes[i].y, 1, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
+            } else {
+                glBindTexture(GL_TEXTURE_2D, textures.glIDs[i]);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, textures.glTexOffsets[i].x, textures.glTexOffsets[i].y, textures.sizes[i].x, textures.sizes[i].y, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
+            }
+        }
+
+        if (atlasTexSizeLimit > 0) {
+            log("Loaded %d textures into %d GL textures.", textures.cnt, textures.uniqueGLIDCnt);
+        }
+
+        return true;
+    }
+
+    bool load_assets(const bool texArrays, const int atlasTexSizeLimit, const char* const filePath) {
         assert(!i_assets);
 
+        // A texture at the atlasing size limit must fit in an atlas along with its padding.
+        if (atlasTexSizeLimit < 0 || atlasTexSizeLimit + ik_texAtlasPadding > min(gk_texAtlasSize.x, gk_texAtlasSize.y)) {
+            log_error("The atlas texture size limit of %d is outside the range of 0 to %d!", atlasTexSizeLimit, min(gk_texAtlasSize.x, gk_texAtlasSize.y) - ik_texAtlasPadding);
+            return false;
+        }
+
         // Allocate memory for assets.
         i_assets = alloc_zeroed<Assets>();
 
@@ -14,11 +579,8 @@ namespace zf3 {
             return false;
         }
 
-        // Open the assets file.
-        FILE* const fs = fopen(gk_assetsFileName, "rb");
-
-        if (!fs) {
-            log_error("Failed to open \"%s\"!", gk_assetsFileName);
+        if (snprintf(i_assets->filePath, sizeof(i_assets->filePath), "%s", filePath) >= static_cast<int>(sizeof(i_assets->filePath))) {
+            log_error("The assets file path \"%s\" exceeds the length limit of %d characters!", filePath, gk_assetsFilePathBufSize - 1);
 
             free(i_assets);
             i_assets = nullptr;
@@ -26,14 +588,11 @@ namespace zf3 {
             return false;
         }
 
-        // Allocate a memory arena for working space.
-        constexpr int scratchSpaceSize = zf3::megabytes_to_bytes(32);
-        MemArena scratchSpace = {};
+        // Map the assets file and read its table of contents.
+        AssetsFileReader fileReader = {};
 
-        if (!init_mem_arena(scratchSpace, scratchSpaceSize)) {
-            log_error("Failed to initialise scratch space for assets initialisation!");
-
-            fclose(fs);
+        if (!map_assets_file(fileReader, filePath)) {
+            log_error("Failed to map \"%s\"!", filePath);
 
             free(i_assets);
             i_assets = nullptr;
@@ -41,86 +600,131 @@ namespace zf3 {
             return false;
         }
 
-        // Reserve space for pixel data, used for both textures and fonts.
-        const int pxDataSize = gk_texChannelCnt * gk_texSizeLimit.x * gk_texSizeLimit.y;
-        auto pxData = push_to_mem_arena<unsigned char>(scratchSpace, pxDataSize);
-        assert(pxData);
+        const auto toc = alloc<AssetsFileTOC>();
 
-        // Load textures.
-        fread(&i_assets->textures.cnt, sizeof(i_assets->textures.cnt), 1, fs);
-
-        if (i_assets->textures.cnt > 0) {
-            glGenTextures(i_assets->textures.cnt, i_assets->textures.glIDs);
+        if (!toc) {
+            log_error("Failed to allocate memory for the assets file table of contents!");
+            unmap_assets_file(fileReader);
+            unload_assets();
+            return false;
+        }
 
-            for (int i = 0; i < i_assets->textures.cnt; ++i) {
-                fread(&i_assets->textures.sizes[i], sizeof(i_assets->textures.sizes[i]), 1, fs);
-                fread(pxData, gk_texChannelCnt * i_assets->textures.sizes[i].x * i_assets->textures.sizes[i].y, 1, fs);
+        if (!read_assets_file_toc(*toc, fileReader, filePath)) {
+            free(toc);
+            unmap_assets_file(fileReader);
+            unload_assets();
+            return false;
+        }
 
-                glBindTexture(GL_TEXTURE_2D, i_assets->textures.glIDs[i]);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, i_assets->textures.sizes[i].x, i_assets->textures.sizes[i].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
-            }
+        // Load textures.
+        if (!load_textures(i_assets->textures, fileReader, *toc, texArrays, atlasTexSizeLimit)) {
+            log_error("Failed to load textures from \"%s\"!", filePath);
+            free(toc);
+            unmap_assets_file(fileReader);
+            unload_assets();
+            return false;
         }
 
         // Load fonts.
-        fread(&i_assets->fonts.cnt, sizeof(i_assets->fonts.cnt), 1, fs);
+        bool corrupt = false;
+
+        i_assets->fonts.cnt = toc->typeCnts[ASSET_TYPE_FONT];
 
         if (i_assets->fonts.cnt > 0) {
             glGenTextures(i_assets->fonts.cnt, i_assets->fonts.texGLIDs);
+        }
 
-            for (int i = 0; i < i_assets->fonts.cnt; ++i) {
-                fread(&i_assets->fonts.arrangementInfos[i], sizeof(i_assets->fonts.arrangementInfos[i]), 1, fs);
-                fread(&i_assets->fonts.texSizes[i], sizeof(i_assets->fonts.texSizes[i]), 1, fs);
-                fread(pxData, gk_texPxDataSizeLimit, 1, fs);
+        // Font textures hold a single alpha channel, which is swizzled so that they sample as white with that alpha. Their rows are tightly packed.
+        static constexpr GLint lk_fontTexSwizzle[4] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
 
-                glBindTexture(GL_TEXTURE_2D, i_assets->fonts.texGLIDs[i]);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, i_assets->fonts.texSizes[i].x, i_assets->fonts.texSizes[i].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (int i = 0; i < i_assets->fonts.cnt; ++i) {
+            AssetsFileReader reader = get_asset_reader(fileReader, get_assets_file_toc_entry(*toc, ASSET_TYPE_FONT, i));
+
+            read_assets_file_val(reader, i_assets->fonts.arrangementInfos[i]);
+            read_assets_file_val(reader, i_assets->fonts.texSizes[i]);
+
+            const Pt2D texSize = i_assets->fonts.texSizes[i];
+
+            if (texSize.x <= 0 || texSize.y <= 0 || texSize.x > gk_texSizeLimit.x || texSize.y > gk_texSizeLimit.y) {
+                corrupt = true;
+                break;
             }
+
+            const Byte* const pxData = read_assets_file_bytes(reader, texSize.x * texSize.y);
+
+            if (!was_asset_read_exactly(reader)) {
+                corrupt = true;
+                break;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, i_assets->fonts.texGLIDs[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, lk_fontTexSwizzle);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, texSize.x, texSize.y, 0, GL_RED, GL_UNSIGNED_BYTE, pxData);
         }
 
-        // Clear the scratch space of the pixel data; it is no longer needed.
-        reset_mem_arena(scratchSpace);
-        pxData = nullptr;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
         // Load sounds.
-        fread(&i_assets->sounds.cnt, sizeof(i_assets->sounds.cnt), 1, fs);
+        if (!corrupt) {
+            i_assets->sounds.cnt = toc->typeCnts[ASSET_TYPE_SOUND];
 
-        if (i_assets->sounds.cnt > 0) {
-            alGenBuffers(i_assets->sounds.cnt, i_assets->sounds.bufALIDs);
+            if (i_assets->sounds.cnt > 0) {
+                alGenBuffers(i_assets->sounds.cnt, i_assets->sounds.bufALIDs);
+            }
 
             for (int i = 0; i < i_assets->sounds.cnt; ++i) {
+                AssetsFileReader reader = get_asset_reader(fileReader, get_assets_file_toc_entry(*toc, ASSET_TYPE_SOUND, i));
+
                 AudioInfo audioInfo;
-                fread(&audioInfo, sizeof(audioInfo), 1, fs);
+                read_assets_file_val(reader, audioInfo);
 
-                const int sampleCnt = audioInfo.sampleCntPerChannel * audioInfo.channelCnt;
-                const auto samples = push_to_mem_arena<AudioSample>(scratchSpace, sampleCnt);
-                fread(samples, sizeof(*samples), sampleCnt, fs);
+                const int samplesSize = reader.size - reader.pos;
+                const Byte* const samples = read_assets_file_bytes(reader, samplesSize);
 
-                const ALenum format = audioInfo.channelCnt == 1 ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
-                alBufferData(i_assets->sounds.bufALIDs[i], format, samples, sizeof(*samples) * sampleCnt, audioInfo.sampleRate);
+                if (reader.overran || samplesSize != static_cast<long long>(sizeof(AudioSample)) * audioInfo.sampleCntPerChannel * audioInfo.channelCnt) {
+                    corrupt = true;
+                    break;
+                }
 
-                reset_mem_arena(scratchSpace);
+                const ALenum format = audioInfo.channelCnt == 1 ? AL_FORMAT_MONO_FLOAT32 : AL_FORMAT_STEREO_FLOAT32;
+                alBufferData(i_assets->sounds.bufALIDs[i], format, samples, samplesSize, audioInfo.sampleRate);
             }
         }
 
-        // Load music.
-        fread(&i_assets->music.cnt, sizeof(i_assets->music.cnt), 1, fs);
+        // Load music, which is streamed from the file during play so only where its sample data is gets recorded.
+        if (!corrupt) {
+            i_assets->music.cnt = toc->typeCnts[ASSET_TYPE_MUSIC];
+
+            for (int i = 0; i < i_assets->music.cnt; ++i) {
+                const AssetsFileTOCEntry& entry = get_assets_file_toc_entry(*toc, ASSET_TYPE_MUSIC, i);
+                AssetsFileReader reader = get_asset_reader(fileReader, entry);
 
-        for (int i = 0; i < i_assets->music.cnt; ++i) {
-            fread(&i_assets->music.infos[i], sizeof(i_assets->music.infos[i]), 1, fs);
+                read_assets_file_val(reader, i_assets->music.infos[i]);
 
-            i_assets->music.sampleDataFilePositions[i] = ftell(fs);
+                i_assets->music.sampleDataFilePositions[i] = entry.offs + reader.pos;
 
-            const int sampleCnt = i_assets->music.infos[i].sampleCntPerChannel * i_assets->music.infos[i].channelCnt;
-            fseek(fs, sizeof(AudioSample) * sampleCnt, SEEK_CUR);
+                const long long sampleCnt = i_assets->music.infos[i].sampleCntPerChannel * i_assets->music.infos[i].channelCnt;
+
+                if (reader.overran || reader.size - reader.pos != static_cast<long long>(sizeof(AudioSample)) * sampleCnt) {
+                    corrupt = true;
+                    break;
+                }
+            }
         }
 
         // Clean up.
-        clean_mem_arena(scratchSpace);
-        fclose(fs);
+        free(toc);
+        unmap_assets_file(fileReader);
+
+        if (corrupt) {
+            log_error("\"%s\" is truncated or corrupt!", filePath);
+            unload_assets();
+            return false;
+        }
 
         return true;
     }
@@ -138,8 +742,8 @@ namespace zf3 {
             glDeleteTextures(i_assets->fonts.cnt, i_assets->fonts.texGLIDs);
         }
 
-        if (i_assets->textures.cnt > 0) {
-            glDeleteTextures(i_assets->textures.cnt, i_assets->textures.glIDs);
+        if (i_assets->textures.uniqueGLIDCnt > 0) {
+            glDeleteTextures(i_assets->textures.uniqueGLIDCnt, i_assets->textures.uniqueGLIDs);
         }
 
         free(i_assets);
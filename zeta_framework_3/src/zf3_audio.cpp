@@ -250,7 +250,7 @@ namespace zf3 {
 
         MusicSrc& src = manager.srcs[id.index];
 
-        src.fs = fopen(gk_assetsFileName, "rb");
+        src.fs = fopen(get_assets().filePath, "rb");
 
         if (!src.fs) {
             return false;
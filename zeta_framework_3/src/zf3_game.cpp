@@ -41,15 +41,23 @@ namespace zf3 {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+        // Submit the shader programs first so that they can compile while everything else loads.
+        PendingShaderProgs pendingShaderProgs = submit_shader_progs(userInfo.texArrays);
+
         if (!init_audio_system()) {
+            abandon_shader_progs(pendingShaderProgs);
             return;
         }
 
-        if (!load_assets()) {
+        if (!load_assets(userInfo.texArrays, userInfo.atlasTexSizeLimit)) {
+            abandon_shader_progs(pendingShaderProgs);
             return;
         }
 
-        game.shaderProgs = load_shader_progs();
+        if (!complete_shader_progs(game.shaderProgs, pendingShaderProgs)) {
+            log_error("Failed to create the shader programs!");
+            return;
+        }
 
         init_rng();
 
@@ -100,7 +108,10 @@ namespace zf3 {
                 save_input_state();
             }
 
-            render_all(game.renderer, game.shaderProgs);
+            if (!render_all(game.renderer, game.shaderProgs)) {
+                return;
+            }
+
             swap_window_buffers();
 
             glfwPollEvents();
@@ -0,0 +1,135 @@
+#include <zf3_particles.h>
+
+namespace zf3 {
+    static float* push_particle_array(MemArena& memArena, const int cap) {
+        return static_cast<float*>(push_to_mem_arena(memArena, sizeof(float) * cap, gk_particleArrayAlignment));
+    }
+
+    // Moves the last particle into the slot of the given one.
+    static void remove_particle(ParticleSystem& sys, const int index) {
+        --sys.cnt;
+
+        sys.posXs[index] = sys.posXs[sys.cnt];
+        sys.posYs[index] = sys.posYs[sys.cnt];
+        sys.velXs[index] = sys.velXs[sys.cnt];
+        sys.velYs[index] = sys.velYs[sys.cnt];
+        sys.rots[index] = sys.rots[sys.cnt];
+        sys.rotVels[index] = sys.rotVels[sys.cnt];
+        sys.alphas[index] = sys.alphas[sys.cnt];
+        sys.alphaVels[index] = sys.alphaVels[sys.cnt];
+        sys.lifetimes[index] = sys.lifetimes[sys.cnt];
+    }
+
+    bool init_particle_system(ParticleSystem& sys, MemArena& memArena, const int cap, const int texIndex, const Rect& srcRect, const Vec2D origin, const Vec2D scale) {
+        assert(cap > 0);
+
+        zero_out(sys);
+
+        sys.texIndex = texIndex;
+        sys.srcRect = srcRect;
+        sys.origin = origin;
+        sys.scale = scale;
+        sys.cap = cap;
+
+        sys.posXs = push_particle_array(memArena, cap);
+        sys.posYs = push_particle_array(memArena, cap);
+        sys.velXs = push_particle_array(memArena, cap);
+        sys.velYs = push_particle_array(memArena, cap);
+        sys.rots = push_particle_array(memArena, cap);
+        sys.rotVels = push_particle_array(memArena, cap);
+        sys.alphas = push_particle_array(memArena, cap);
+        sys.alphaVels = push_particle_array(memArena, cap);
+        sys.lifetimes = static_cast<int*>(push_to_mem_arena(memArena, sizeof(int) * cap, gk_particleArrayAlignment));
+
+        if (!sys.posXs || !sys.posYs || !sys.velXs || !sys.velYs || !sys.rots || !sys.rotVels || !sys.alphas || !sys.alphaVels || !sys.lifetimes) {
+            log_error("Failed to push particle system arrays to the memory arena!");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool spawn_particle(ParticleSystem& sys, const ParticleSpawnInfo& info) {
+        if (sys.cnt == sys.cap) {
+            return false;
+        }
+
+        const int index = sys.cnt;
+
+        sys.posXs[index] = info.pos.x;
+        sys.posYs[index] = info.pos.y;
+        sys.velXs[index] = info.vel.x;
+        sys.velYs[index] = info.vel.y;
+        sys.rots[index] = info.rot;
+        sys.rotVels[index] = info.rotVel;
+        sys.alphas[index] = info.alpha;
+        sys.alphaVels[index] = info.alphaVel;
+        sys.lifetimes[index] = info.lifetime;
+
+        ++sys.cnt;
+
+        return true;
+    }
+
+    void update_particle_system(ParticleSystem& sys) {
+        const int cnt = sys.cnt;
+
+        // Each property is integrated in its own loop with no branches or aliasing between arrays, which compilers turn into vector code.
+        float* const __restrict posXs = sys.posXs;
+        float* const __restrict posYs = sys.posYs;
+        float* const __restrict rots = sys.rots;
+        float* const __restrict alphas = sys.alphas;
+        int* const __restrict lifetimes = sys.lifetimes;
+        const float* const __restrict velXs = sys.velXs;
+        const float* const __restrict velYs = sys.velYs;
+        const float* const __restrict rotVels = sys.rotVels;
+        const float* const __restrict alphaVels = sys.alphaVels;
+
+        for (int i = 0; i < cnt; ++i) {
+            posXs[i] += velXs[i];
+        }
+
+        for (int i = 0; i < cnt; ++i) {
+            posYs[i] += velYs[i];
+        }
+
+        for (int i = 0; i < cnt; ++i) {
+            rots[i] += rotVels[i];
+        }
+
+        for (int i = 0; i < cnt; ++i) {
+            alphas[i] = min(alphas[i] + alphaVels[i], 1.0f);
+        }
+
+        for (int i = 0; i < cnt; ++i) {
+            --lifetimes[i];
+        }
+
+        // Despawn expired and fully faded particles, with the index held in place after a removal so the particle moved into it is checked too.
+        int i = 0;
+
+        while (i < sys.cnt) {
+            if (sys.lifetimes[i] <= 0 || sys.alphas[i] <= 0.0f) {
+                remove_particle(sys, i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    bool write_particle_system_to_batch(Renderer& renderer, const int layerIndex, const ParticleSystem& sys, const int depth) {
+        const SpriteArrays sprites = {
+            .texIndex = sys.texIndex,
+            .srcRect = sys.srcRect,
+            .origin = sys.origin,
+            .scale = sys.scale,
+            .posXs = sys.posXs,
+            .posYs = sys.posYs,
+            .rots = sys.rots,
+            .alphas = sys.alphas,
+            .cnt = sys.cnt
+        };
+
+        return write_sprite_arrays_to_batch(renderer, layerIndex, sprites, depth);
+    }
+}
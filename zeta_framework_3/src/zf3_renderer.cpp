@@ -1,317 +1,1726 @@
 #include <zf3_renderer.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZF3_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace zf3 {
     static constexpr int ik_spriteBatchSlotVertCnt = gk_spriteQuadShaderProgVertCnt * 4;
     static constexpr int ik_spriteBatchSlotVertsSize = sizeof(float) * ik_spriteBatchSlotVertCnt;
+    static constexpr int ik_spriteVertsStride = sizeof(float) * gk_spriteQuadShaderProgVertCnt;
+
+    static constexpr int ik_spriteBatchSlotInstSize = sizeof(SpriteBatchInst);
+
+    static constexpr int ik_charBatchSlotVertsCnt = gk_charQuadShaderProgVertCnt * 4;
+    static constexpr int ik_charBatchSlotVertsSize = sizeof(float) * ik_charBatchSlotVertsCnt;
+
+    static constexpr int ik_quadElemBufQuadCnt = max(gk_spriteBatchSlotLimit, gk_charBatchSlotLimit);
+    static_assert(ik_quadElemBufQuadCnt * 4 <= 65536, "Quad indices must fit in an unsigned short.");
+
+    static_assert(ik_spriteBatchSlotVertsSize * gk_spriteBatchSlotLimit <= gk_vertRingBufRegionSize, "A full sprite batch must fit in one vertex ring buffer region.");
+
+    static_assert(gk_renderLayerCharBatchLimit == gk_charQuadShaderProgBatchLimit);
+    static_assert(sizeof(CharBatchShaderProps) == 32);
+
+    static constexpr GLID ik_unknownGLID = static_cast<GLID>(-1);
+
+    static constexpr int ik_spriteBatchMinCap = 4;
+    static constexpr int ik_spriteBatchMinSlotCap = 256;
+    static constexpr int ik_spriteCmdMinCap = 1024;
+    static constexpr int ik_charBatchMinCap = 16;
+
+    static constexpr int ik_spriteBatchDrawLimit = 64; // The most sprite batches submitted in one multi-draw call.
+
+    struct DrawElemsIndirectCmd {
+        GLuint cnt;
+        GLuint instCnt;
+        GLuint firstIndex;
+        GLint baseVert;
+        GLuint baseInst;
+    };
+
+    struct DrawArraysIndirectCmd {
+        GLuint cnt;
+        GLuint instCnt;
+        GLuint first;
+        GLuint baseInst;
+    };
+
+    // Sprite batches drawn in one call, each by a command in the layout GL reads indirect draws in.
+    struct SpriteBatchDraws {
+        union {
+            DrawElemsIndirectCmd elemsCmds[ik_spriteBatchDrawLimit];
+            DrawArraysIndirectCmd arraysCmds[ik_spriteBatchDrawLimit];
+        };
+
+        int cnt;
+        SpriteBatchTransData texData; // The textures bound for the draws, which is every texture unit used by any of the batches, and the flags of the batches combined.
+    };
+
+    static QuadBuf gen_char_quad_buf(const int quadCnt, const GLID quadElemBufGLID, const float* const verts = nullptr) {
+        assert(quadCnt > 0);
+
+        QuadBuf buf = {};
+
+        // Generate vertex array.
+        glGenVertexArrays(1, &buf.vertArrayGLID);
+        glBindVertexArray(buf.vertArrayGLID);
+
+        // Generate vertex buffer.
+        glGenBuffers(1, &buf.vertBufGLID);
+        glBindBuffer(GL_ARRAY_BUFFER, buf.vertBufGLID);
+        glBufferData(GL_ARRAY_BUFFER, ik_charBatchSlotVertsSize * quadCnt, verts, GL_DYNAMIC_DRAW);
+
+        // Reference the shared element buffer, which the vertex array records.
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadElemBufGLID);
+
+        // Set vertex attribute pointers.
+        const int vertsStride = sizeof(float) * gk_charQuadShaderProgVertCnt;
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 0));
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 2));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 4));
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray(0);
+
+        return buf;
+    }
+
+    static GLID gen_sprite_vert_array(const GLID vertBufGLID, const GLID quadElemBufGLID) {
+        GLID vertArrayGLID;
+        glGenVertexArrays(1, &vertArrayGLID);
+        glBindVertexArray(vertArrayGLID);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vertBufGLID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadElemBufGLID);
+
+        // Set vertex attribute pointers.
+        const int vertsStride = ik_spriteVertsStride;
+
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 0));
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 2));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 4));
+        glEnableVertexAttribArray(2);
+
+        glVertexAttribPointer(3, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 6));
+        glEnableVertexAttribArray(3);
+
+        glVertexAttribPointer(4, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 7));
+        glEnableVertexAttribArray(4);
+
+        glVertexAttribPointer(5, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 8));
+        glEnableVertexAttribArray(5);
+
+        glVertexAttribPointer(6, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 10));
+        glEnableVertexAttribArray(6);
+
+        glBindVertexArray(0);
+
+        return vertArrayGLID;
+    }
+
+    static GLID gen_sprite_inst_vert_array(const GLID instBufGLID, const GLID unitQuadVertBufGLID) {
+        GLID vertArrayGLID;
+        glGenVertexArrays(1, &vertArrayGLID);
+        glBindVertexArray(vertArrayGLID);
+
+        // Set the unit quad vertex attribute pointer, shared by all instances.
+        glBindBuffer(GL_ARRAY_BUFFER, unitQuadVertBufGLID);
+        glVertexAttribPointer(0, 2, GL_FLOAT, false, sizeof(Vec2D), nullptr);
+        glEnableVertexAttribArray(0);
+
+        // Set instance attribute pointers.
+        glBindBuffer(GL_ARRAY_BUFFER, instBufGLID);
+
+        const int instStride = ik_spriteBatchSlotInstSize;
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, false, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, pos)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, false, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, size)));
+        glVertexAttribPointer(3, 2, GL_FLOAT, false, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, origin)));
+        glVertexAttribPointer(4, 1, GL_FLOAT, false, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, rot)));
+        glVertexAttribPointer(5, 1, GL_FLOAT, false, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, alpha)));
+        glVertexAttribPointer(6, 4, GL_UNSIGNED_SHORT, true, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, texCoords)));
+        glVertexAttribIPointer(7, 1, GL_INT, instStride, reinterpret_cast<void*>(offsetof(SpriteBatchInst, texUnit)));
+
+        for (int i = 1; i <= 7; ++i) {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+
+        glBindVertexArray(0);
+
+        return vertArrayGLID;
+    }
+
+    static void invalidate_gl_state_cache_bindings(GLStateCache& cache) {
+        cache.progGLID = ik_unknownGLID;
+        cache.vertArrayGLID = ik_unknownGLID;
+        cache.activeTexUnit = -1;
+        cache.blendEnabled = -1;
+
+        for (int i = 0; i < gk_texUnitLimit; ++i) {
+            cache.texUnitGLIDs[i] = ik_unknownGLID;
+        }
+    }
+
+    // Returns whether the given value matches the one last recorded for the state, recording it if not. The caller only has to issue the GL call if false is returned.
+    template<typename T>
+    static bool is_gl_state_cached(GLStateCache& cache, T& cachedVal, const T val) {
+        if (cachedVal == val) {
+            ++cache.skippedCallCnt;
+            return true;
+        }
+
+        cachedVal = val;
+        ++cache.issuedCallCnt;
+
+        return false;
+    }
+
+    static void use_shader_prog(GLStateCache& cache, const GLID glID) {
+        if (!is_gl_state_cached(cache, cache.progGLID, glID)) {
+            glUseProgram(glID);
+        }
+    }
+
+    static void bind_vert_array(GLStateCache& cache, const GLID glID) {
+        if (!is_gl_state_cached(cache, cache.vertArrayGLID, glID)) {
+            glBindVertexArray(glID);
+        }
+    }
+
+    static void set_blend_enabled(GLStateCache& cache, const bool enabled) {
+        if (!is_gl_state_cached(cache, cache.blendEnabled, static_cast<int>(enabled))) {
+            if (enabled) {
+                glEnable(GL_BLEND);
+            } else {
+                glDisable(GL_BLEND);
+            }
+        }
+    }
+
+    static void bind_tex_to_unit(GLStateCache& cache, const int unit, const GLenum target, const GLID glID) {
+        assert(unit >= 0 && unit < gk_texUnitLimit);
+
+        if (cache.texUnitGLIDs[unit] == glID) {
+            ++cache.skippedCallCnt;
+            return;
+        }
+
+        if (!is_gl_state_cached(cache, cache.activeTexUnit, unit)) {
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+
+        cache.texUnitGLIDs[unit] = glID;
+        ++cache.issuedCallCnt;
+
+        glBindTexture(target, glID);
+    }
+
+    // Works like is_gl_state_cached for the value of a uniform of the program in use. If the cache is full the uniform is just not tracked.
+    static bool is_uniform_val_cached(GLStateCache& cache, const int loc, const void* const val, const int valSize) {
+        assert(valSize <= gk_glUniformCacheValSizeLimit);
+
+        GLUniformCacheEntry* entry = nullptr;
+
+        for (int i = 0; i < cache.uniformCnt; ++i) {
+            if (cache.uniforms[i].progGLID == cache.progGLID && cache.uniforms[i].loc == loc) {
+                entry = &cache.uniforms[i];
+                break;
+            }
+        }
+
+        if (entry && memcmp(entry->val, val, valSize) == 0) {
+            ++cache.skippedCallCnt;
+            return true;
+        }
+
+        if (!entry && cache.uniformCnt < gk_glUniformCacheLimit) {
+            entry = &cache.uniforms[cache.uniformCnt];
+            entry->progGLID = cache.progGLID;
+            entry->loc = loc;
+            ++cache.uniformCnt;
+        }
+
+        if (entry) {
+            memcpy(entry->val, val, valSize);
+        }
+
+        ++cache.issuedCallCnt;
+
+        return false;
+    }
+
+    static void set_uniform_ints(GLStateCache& cache, const int loc, const int* const ints, const int cnt) {
+        if (!is_uniform_val_cached(cache, loc, ints, sizeof(*ints) * cnt)) {
+            glUniform1iv(loc, cnt, ints);
+        }
+    }
+
+    static_assert(gk_charBatchBufMinSlotCnt << (gk_charBatchBufSizeClassCnt - 1) == gk_charBatchSlotLimit);
+
+    static int get_char_batch_buf_size_class(const int slotCnt) {
+        int sizeClass = 0;
+
+        while ((gk_charBatchBufMinSlotCnt << sizeClass) < slotCnt) {
+            ++sizeClass;
+        }
+
+        assert(sizeClass < gk_charBatchBufSizeClassCnt);
+
+        return sizeClass;
+    }
+
+    // The CPU copy kept with each buffer holds the vertex data of every slot, followed by the character last written to each slot.
+    static char* get_char_batch_buf_text(float* const slotVerts, const int sizeClass) {
+        return reinterpret_cast<char*>(slotVerts + (ik_charBatchSlotVertsCnt * (gk_charBatchBufMinSlotCnt << sizeClass)));
+    }
+
+    // Takes a buffer of the size class from the pool, along with its CPU copy of the vertex data and text. Returns false if a new buffer was needed but its CPU copy could not be allocated.
+    static bool take_char_batch_buf(Renderer& renderer, const int sizeClass, QuadBuf& buf, float*& slotVerts) {
+        CharBatchBufPool& pool = renderer.charBatchBufPool;
+
+        if (pool.freeBufCnts[sizeClass] > 0) {
+            --pool.freeBufCnts[sizeClass];
+            buf = pool.freeBufs[sizeClass][pool.freeBufCnts[sizeClass]];
+            slotVerts = pool.freeBufSlotVerts[sizeClass][pool.freeBufCnts[sizeClass]];
+        } else {
+            const int slotCnt = gk_charBatchBufMinSlotCnt << sizeClass;
+
+            slotVerts = reinterpret_cast<float*>(alloc_zeroed<Byte>((ik_charBatchSlotVertsSize + 1) * slotCnt));
+
+            if (!slotVerts) {
+                log_error("Failed to allocate memory for a character batch buffer!");
+                return false;
+            }
+
+            // The buffer starts out matching its zeroed copy.
+            buf = gen_char_quad_buf(slotCnt, renderer.quadElemBufGLID, slotVerts);
+
+            ++pool.bufGenCnt;
+        }
+
+        ++pool.inUseBufCnts[sizeClass];
+        pool.inUseBufHighWaterMarks[sizeClass] = max(pool.inUseBufHighWaterMarks[sizeClass], pool.inUseBufCnts[sizeClass]);
+
+        return true;
+    }
+
+    static void delete_char_batch_buf(const QuadBuf& buf, float* const slotVerts) {
+        glDeleteVertexArrays(1, &buf.vertArrayGLID);
+        glDeleteBuffers(1, &buf.vertBufGLID);
+        free(slotVerts);
+    }
+
+    static void return_char_batch_buf(CharBatchBufPool& pool, const int sizeClass, const QuadBuf& buf, float* const slotVerts) {
+        assert(pool.inUseBufCnts[sizeClass] > 0);
+        --pool.inUseBufCnts[sizeClass];
+
+        if (pool.freeBufCnts[sizeClass] == gk_charBatchBufPoolFreeLimit) {
+            delete_char_batch_buf(buf, slotVerts);
+            return;
+        }
+
+        pool.freeBufs[sizeClass][pool.freeBufCnts[sizeClass]] = buf;
+        pool.freeBufSlotVerts[sizeClass][pool.freeBufCnts[sizeClass]] = slotVerts;
+        ++pool.freeBufCnts[sizeClass];
+        pool.freeBufHighWaterMarks[sizeClass] = max(pool.freeBufHighWaterMarks[sizeClass], pool.freeBufCnts[sizeClass]);
+    }
+
+    static inline int get_sprite_batch_slot_size(const RenderLayer& layer) {
+        return layer.instanced ? ik_spriteBatchSlotInstSize : ik_spriteBatchSlotVertsSize;
+    }
+
+    static inline unsigned short to_norm_ushort(const float value) {
+        return static_cast<unsigned short>((value * 65535.0f) + 0.5f);
+    }
+
+    static int add_tex_unit_to_sprite_batch(SpriteBatchTransData& batchTransData, const GLID texGLID) {
+        for (int i = 0; i < batchTransData.texUnitsInUse; ++i) {
+            if (batchTransData.texUnitGLIDs[i] == texGLID) {
+                return i;
+            }
+        }
+
+        if (batchTransData.texUnitsInUse == gk_texUnitLimit) {
+            return -1;
+        }
+
+        batchTransData.texUnitGLIDs[batchTransData.texUnitsInUse] = texGLID;
+
+        return batchTransData.texUnitsInUse++;
+    }
+
+    // Calculates the axis-aligned bounds of a sprite scaled and rotated about its origin, matching the sprite vertex shaders.
+    static RectFloat calc_sprite_bounds(const Vec2D pos, const Vec2D size, const Vec2D origin, const float rot) {
+        const Vec2D centerOffs = {(0.5f - origin.x) * size.x, (0.5f - origin.y) * size.y};
+
+        if (rot == 0.0f) {
+            const Vec2D extents = {fabsf(size.x), fabsf(size.y)};
+            return {pos + centerOffs - (extents / 2.0f), extents};
+        }
+
+        const float rotCos = cosf(rot);
+        const float rotSin = sinf(rot);
+
+        const Vec2D center = pos + Vec2D {(centerOffs.x * rotCos) + (centerOffs.y * rotSin), (centerOffs.y * rotCos) - (centerOffs.x * rotSin)};
+
+        const Vec2D extents = {
+            fabsf(size.x * rotCos) + fabsf(size.y * rotSin),
+            fabsf(size.x * rotSin) + fabsf(size.y * rotCos)
+        };
+
+        return {center - (extents / 2.0f), extents};
+    }
+
+    // Returns false if memory for the batch could not be allocated, in which case the layer is left as it was. Arrays grown before a later one fails keep their new size, which is harmless as the capacity is only raised once all have grown.
+    static bool add_sprite_batch(RenderLayer& layer) {
+        if (layer.spriteBatchCnt == layer.spriteBatchCap) {
+            const int cap = max(layer.spriteBatchCap * 2, ik_spriteBatchMinCap);
+
+            const auto slots = realloc_zeroed(layer.spriteBatchSlots, layer.spriteBatchCap, cap);
+
+            if (!slots) {
+                log_error("Failed to allocate memory for sprite batches!");
+                return false;
+            }
+
+            layer.spriteBatchSlots = slots;
+
+            const auto slotCaps = realloc_zeroed(layer.spriteBatchSlotCaps, layer.spriteBatchCap, cap);
+
+            if (!slotCaps) {
+                log_error("Failed to allocate memory for sprite batches!");
+                return false;
+            }
+
+            layer.spriteBatchSlotCaps = slotCaps;
+
+            const auto transDatas = realloc_zeroed(layer.spriteBatchTransDatas, layer.spriteBatchCap, cap);
+
+            if (!transDatas) {
+                log_error("Failed to allocate memory for sprite batches!");
+                return false;
+            }
+
+            layer.spriteBatchTransDatas = transDatas;
+
+            layer.spriteBatchCap = cap;
+        }
+
+        layer.spriteBatchSlots[layer.spriteBatchCnt] = alloc<Byte>(get_sprite_batch_slot_size(layer) * ik_spriteBatchMinSlotCap);
+
+        if (!layer.spriteBatchSlots[layer.spriteBatchCnt]) {
+            log_error("Failed to allocate memory for sprite batch slots!");
+            return false;
+        }
+
+        layer.spriteBatchSlotCaps[layer.spriteBatchCnt] = ik_spriteBatchMinSlotCap;
+
+        ++layer.spriteBatchCnt;
+
+        return true;
+    }
+
+    static void write_sprite_inst(Byte* const slot, const Vec2D pos, const Rect& srcRect, const Pt2D texSize, const Vec2D origin, const float rot, const Vec2D scale, const float alpha, const int texUnit) {
+        const SpriteBatchInst inst = {
+            .pos = pos,
+            .size = {srcRect.width * scale.x, srcRect.height * scale.y},
+            .origin = origin,
+            .rot = rot,
+            .alpha = alpha,
+            .texCoords = {
+                to_norm_ushort(static_cast<float>(srcRect.x) / texSize.x),
+                to_norm_ushort(static_cast<float>(srcRect.y) / texSize.y),
+                to_norm_ushort(static_cast<float>(srcRect.x + srcRect.width) / texSize.x),
+                to_norm_ushort(static_cast<float>(srcRect.y + srcRect.height) / texSize.y)
+            },
+            .texUnit = texUnit
+        };
+
+        memcpy(slot, &inst, sizeof(inst));
+    }
+
+#ifdef ZF3_SSE2
+    // Builds the 44 floats of the four vertices as eleven 4-wide vectors shuffled together from a few computed ones, so the slot is written in eleven stores rather than 44. Produces exactly what the scalar version does.
+    static void write_sprite_verts(Byte* const slot, const Vec2D pos, const Rect& srcRect, const Pt2D texSize, const Vec2D origin, const float rot, const Vec2D scale, const float alpha, const int texUnit) {
+        // Vertex offsets from the origin, in the order x of the left and right corners, then y of the top and bottom.
+        const __m128 offsVec = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f), _mm_setr_ps(origin.x, origin.x, origin.y, origin.y)), _mm_setr_ps(scale.x, scale.x, scale.y, scale.y));
+
+        const __m128 posSizeVec = _mm_setr_ps(pos.x, pos.y, static_cast<float>(srcRect.width), static_cast<float>(srcRect.height));
+        const __m128 rotUnitAlphaVec = _mm_setr_ps(rot, static_cast<float>(texUnit), alpha, 0.0f);
+
+        // Top-left and bottom-right texture coordinates.
+        const __m128 texCoordsVec = _mm_div_ps(
+            _mm_cvtepi32_ps(_mm_setr_epi32(srcRect.x, srcRect.y, srcRect.x + srcRect.width, srcRect.y + srcRect.height)),
+            _mm_cvtepi32_ps(_mm_setr_epi32(texSize.x, texSize.y, texSize.x, texSize.y))
+        );
+
+        const __m128 sizeRotVec = _mm_shuffle_ps(posSizeVec, rotUnitAlphaVec, _MM_SHUFFLE(0, 0, 3, 3)); // h, h, rot, rot
+
+        float* const verts = reinterpret_cast<float*>(slot);
+
+        // x, y, pos.x, pos.y | w, h, rot, unit | u0, v0, alpha, x
+        _mm_storeu_ps(verts + 0, _mm_shuffle_ps(offsVec, posSizeVec, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(verts + 4, _mm_shuffle_ps(posSizeVec, rotUnitAlphaVec, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_storeu_ps(verts + 8, _mm_shuffle_ps(texCoordsVec, _mm_shuffle_ps(rotUnitAlphaVec, offsVec, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0)));
+
+        // y, pos.x, pos.y, w | h, rot, unit, u1 | v0, alpha, x, y
+        _mm_storeu_ps(verts + 12, _mm_shuffle_ps(_mm_shuffle_ps(offsVec, posSizeVec, _MM_SHUFFLE(0, 0, 2, 2)), posSizeVec, _MM_SHUFFLE(2, 1, 2, 0)));
+        _mm_storeu_ps(verts + 16, _mm_shuffle_ps(sizeRotVec, _mm_shuffle_ps(rotUnitAlphaVec, texCoordsVec, _MM_SHUFFLE(2, 2, 1, 1)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(verts + 20, _mm_shuffle_ps(_mm_shuffle_ps(texCoordsVec, rotUnitAlphaVec, _MM_SHUFFLE(2, 2, 1, 1)), offsVec, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        // pos.x, pos.y, w, h | rot, unit, u1, v1 | alpha, x, y, pos.x
+        _mm_storeu_ps(verts + 24, posSizeVec);
+        _mm_storeu_ps(verts + 28, _mm_shuffle_ps(rotUnitAlphaVec, texCoordsVec, _MM_SHUFFLE(3, 2, 1, 0)));
+        _mm_storeu_ps(verts + 32, _mm_shuffle_ps(_mm_shuffle_ps(rotUnitAlphaVec, offsVec, _MM_SHUFFLE(0, 0, 2, 2)), _mm_shuffle_ps(offsVec, posSizeVec, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+
+        // pos.y, w, h, rot | unit, u0, v1, alpha
+        _mm_storeu_ps(verts + 36, _mm_shuffle_ps(posSizeVec, sizeRotVec, _MM_SHUFFLE(2, 0, 2, 1)));
+        _mm_storeu_ps(verts + 40, _mm_shuffle_ps(_mm_shuffle_ps(rotUnitAlphaVec, texCoordsVec, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(texCoordsVec, rotUnitAlphaVec, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#else
+    static void write_sprite_verts(Byte* const slot, const Vec2D pos, const Rect& srcRect, const Pt2D texSize, const Vec2D origin, const float rot, const Vec2D scale, const float alpha, const int texUnit) {
+        const float verts[] = {
+            (0.0f - origin.x) * scale.x,
+            (0.0f - origin.y) * scale.y,
+            pos.x,
+            pos.y,
+            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
+            rot,
+            static_cast<float>(texUnit),
+            static_cast<float>(srcRect.x) / texSize.x, static_cast<float>(srcRect.y) / texSize.y,
+            alpha,
+
+            (1.0f - origin.x) * scale.x,
+            (0.0f - origin.y) * scale.y,
+            pos.x,
+            pos.y,
+            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
+            rot,
+            static_cast<float>(texUnit),
+            static_cast<float>(srcRect.x + srcRect.width) / texSize.x,
+            static_cast<float>(srcRect.y) / texSize.y,
+            alpha,
+
+            (1.0f - origin.x) * scale.x,
+            (1.0f - origin.y) * scale.y,
+            pos.x,
+            pos.y,
+            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
+            rot,
+            static_cast<float>(texUnit),
+            static_cast<float>(srcRect.x + srcRect.width) / texSize.x,
+            static_cast<float>(srcRect.y + srcRect.height) / texSize.y,
+            alpha,
+
+            (0.0f - origin.x) * scale.x,
+            (1.0f - origin.y) * scale.y,
+            pos.x,
+            pos.y,
+            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
+            rot,
+            static_cast<float>(texUnit),
+            static_cast<float>(srcRect.x) / texSize.x,
+            static_cast<float>(srcRect.y + srcRect.height) / texSize.y,
+            alpha
+        };
+
+        memcpy(slot, verts, sizeof(verts));
+    }
+#endif
+
+    // The value written into sprites to pick out their texture. If textures are loaded into arrays, it holds the array layer as well as the unit, which the sprite fragment shaders unpack.
+    static inline int get_sprite_tex_unit_val(const Textures& textures, const int texIndex, const int texUnit) {
+        return textures.inArrays ? texUnit + (textures.glTexLayers[texIndex] * gk_texUnitLimit) : texUnit;
+    }
+
+    // Moves on to the next sprite batch if the current one cannot take a sprite of the texture, then returns the value the sprite should carry to sample from it, or -1 if a batch could not be added.
+    static int prepare_sprite_batch_slot(RenderLayer& layer, const int texIndex) {
+        if (layer.spriteBatchCnt == 0 && !add_sprite_batch(layer)) {
+            return -1;
+        }
+
+        // Textures packed into the same atlas or array share a texture unit.
+        const Textures& textures = get_assets().textures;
+
+        SpriteBatchTransData* batchTransData = &layer.spriteBatchTransDatas[layer.spriteBatchesFilled];
+
+        int texUnit;
+
+        if (batchTransData->slotsUsed == gk_spriteBatchSlotLimit || (texUnit = add_tex_unit_to_sprite_batch(*batchTransData, textures.glIDs[texIndex])) == -1) {
+            if (layer.spriteBatchesFilled + 1 == layer.spriteBatchCnt && !add_sprite_batch(layer)) {
+                return -1;
+            }
+
+            ++layer.spriteBatchesFilled;
+
+            batchTransData = &layer.spriteBatchTransDatas[layer.spriteBatchesFilled];
+            texUnit = add_tex_unit_to_sprite_batch(*batchTransData, textures.glIDs[texIndex]);
+        }
+
+        return get_sprite_tex_unit_val(textures, texIndex, texUnit);
+    }
+
+    static bool grow_sprite_batch_slots(RenderLayer& layer, const int batchIndex) {
+        const int slotSize = get_sprite_batch_slot_size(layer);
+        const int cap = min(layer.spriteBatchSlotCaps[batchIndex] * 2, gk_spriteBatchSlotLimit);
+
+        const auto slots = static_cast<Byte*>(realloc(layer.spriteBatchSlots[batchIndex], slotSize * cap));
+
+        if (!slots) {
+            log_error("Failed to allocate memory for sprite batch slots!");
+            return false;
+        }
+
+        layer.spriteBatchSlots[batchIndex] = slots;
+        layer.spriteBatchSlotCaps[batchIndex] = cap;
+
+        return true;
+    }
+
+    static void use_sprite_shader_prog(GLStateCache& cache, const SpriteQuadShaderProg& prog, const int viewIndex) {
+        static int lk_texUnits[gk_texUnitLimit];
+        static bool lk_texUnitsInitialized = false;
+
+        if (!lk_texUnitsInitialized) {
+            for (int i = 0; i < gk_texUnitLimit; ++i) {
+                lk_texUnits[i] = i;
+            }
+
+            lk_texUnitsInitialized = true;
+        }
+
+        use_shader_prog(cache, prog.glID);
+
+        set_uniform_ints(cache, prog.viewIndexUniLoc, &viewIndex, 1);
+        set_uniform_ints(cache, prog.texturesUniLoc, lk_texUnits, gk_texUnitLimit);
+    }
+
+    // The cheapest program variant that draws every sprite in the batch correctly.
+    static int get_sprite_shader_prog_variant(const SpriteBatchTransData& batchTransData) {
+        int variant = 0;
+
+        if (!batchTransData.rotated) {
+            variant |= gk_spriteQuadShaderProgNoRotFlag;
+        }
+
+        if (!batchTransData.translucent) {
+            variant |= gk_spriteQuadShaderProgOpaqueFlag;
+        }
+
+        return variant;
+    }
+
+    // Batches can be drawn together if each texture unit that they both use holds the same texture in each.
+    static bool can_sprite_batches_share_draw(const SpriteBatchTransData& a, const SpriteBatchTransData& b) {
+        const int sharedTexUnitCnt = min(a.texUnitsInUse, b.texUnitsInUse);
+
+        for (int i = 0; i < sharedTexUnitCnt; ++i) {
+            if (a.texUnitGLIDs[i] != b.texUnitGLIDs[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static void add_sprite_batch_draw(SpriteBatchDraws& draws, const SpriteBatchTransData& batchTransData, const int base, const bool instanced) {
+        assert(draws.cnt < ik_spriteBatchDrawLimit);
+
+        if (draws.cnt == 0) {
+            draws.texData = batchTransData;
+        } else {
+            assert(can_sprite_batches_share_draw(draws.texData, batchTransData));
+
+            for (int i = draws.texData.texUnitsInUse; i < batchTransData.texUnitsInUse; ++i) {
+                draws.texData.texUnitGLIDs[i] = batchTransData.texUnitGLIDs[i];
+            }
+
+            draws.texData.texUnitsInUse = max(draws.texData.texUnitsInUse, batchTransData.texUnitsInUse);
+
+            draws.texData.rotated |= batchTransData.rotated;
+            draws.texData.translucent |= batchTransData.translucent;
+        }
+
+        if (instanced) {
+            draws.arraysCmds[draws.cnt] = {4, static_cast<GLuint>(batchTransData.slotsUsed), 0, static_cast<GLuint>(base)};
+        } else {
+            draws.elemsCmds[draws.cnt] = {static_cast<GLuint>(6 * batchTransData.slotsUsed), 1, 0, base, 0};
+        }
+
+        ++draws.cnt;
+    }
+
+    // Draws the batches with a single call, using the cheapest variant of the program that suits all of them. Where there are multiple, their commands are streamed into the vertex ring buffer, which is bound as the indirect draw buffer for the frame. Returns false if they could not be streamed.
+    static bool submit_sprite_batch_draws(Renderer& renderer, SpriteBatchDraws& draws, const SpriteQuadShaderProg* const progVariants, const int viewIndex, const bool instanced) {
+        if (draws.cnt == 0) {
+            return true;
+        }
+
+        const int variant = get_sprite_shader_prog_variant(draws.texData);
+        use_sprite_shader_prog(renderer.glStateCache, progVariants[variant], viewIndex);
+        set_blend_enabled(renderer.glStateCache, !(variant & gk_spriteQuadShaderProgOpaqueFlag));
+
+        const bool texArrays = get_assets().textures.inArrays;
+
+        for (int i = 0; i < draws.texData.texUnitsInUse; ++i) {
+            bind_tex_to_unit(renderer.glStateCache, i, texArrays ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, draws.texData.texUnitGLIDs[i]);
+        }
+
+        if (draws.cnt == 1) {
+            if (instanced) {
+                const DrawArraysIndirectCmd& cmd = draws.arraysCmds[0];
+                glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, cmd.cnt, cmd.instCnt, cmd.baseInst);
+            } else {
+                const DrawElemsIndirectCmd& cmd = draws.elemsCmds[0];
+                glDrawElementsBaseVertex(GL_TRIANGLES, cmd.cnt, GL_UNSIGNED_SHORT, nullptr, cmd.baseVert);
+            }
+        } else {
+            RingBufRange cmdsRange;
+
+            if (instanced) {
+                if (!write_to_ring_buf(renderer.vertRingBuf, cmdsRange, draws.arraysCmds, sizeof(DrawArraysIndirectCmd) * draws.cnt, alignof(DrawArraysIndirectCmd))) {
+                    return false;
+                }
+
+                glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void*>(static_cast<intptr_t>(cmdsRange.offs)), draws.cnt, 0);
+            } else {
+                if (!write_to_ring_buf(renderer.vertRingBuf, cmdsRange, draws.elemsCmds, sizeof(DrawElemsIndirectCmd) * draws.cnt, alignof(DrawElemsIndirectCmd))) {
+                    return false;
+                }
+
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(static_cast<intptr_t>(cmdsRange.offs)), draws.cnt, 0);
+            }
+        }
+
+        draws.cnt = 0;
+
+        return true;
+    }
+
+    // Writes a sprite into the next slot of the current batch, which must have been prepared for its texture. Returns false if the slots of the batch could not be grown to fit it.
+    static bool write_sprite_to_batch_slot(RenderLayer& layer, const int texIndex, const int texUnit, const Vec2D pos, const Rect& srcRectTex, const Vec2D origin, const float rot, const Vec2D scale, const float alpha) {
+        const Textures& textures = get_assets().textures;
+
+        SpriteBatchTransData& batchTransData = layer.spriteBatchTransDatas[layer.spriteBatchesFilled];
+        assert(batchTransData.slotsUsed < gk_spriteBatchSlotLimit);
+
+        if (batchTransData.slotsUsed == layer.spriteBatchSlotCaps[layer.spriteBatchesFilled] && !grow_sprite_batch_slots(layer, layer.spriteBatchesFilled)) {
+            return false;
+        }
+
+        // Map the source rectangle to where the texture is within its GL texture.
+        const Pt2D texSize = textures.glTexSizes[texIndex];
+        const Rect srcRect = {srcRectTex.x + textures.glTexOffsets[texIndex].x, srcRectTex.y + textures.glTexOffsets[texIndex].y, srcRectTex.width, srcRectTex.height};
+
+        Byte* const slot = layer.spriteBatchSlots[layer.spriteBatchesFilled] + (batchTransData.slotsUsed * get_sprite_batch_slot_size(layer));
+
+        if (layer.instanced) {
+            write_sprite_inst(slot, pos, srcRect, texSize, origin, rot, scale, alpha, texUnit);
+        } else {
+            write_sprite_verts(slot, pos, srcRect, texSize, origin, rot, scale, alpha, texUnit);
+        }
+
+        ++batchTransData.slotsUsed;
+        batchTransData.rotated |= rot != 0.0f;
+        batchTransData.translucent |= alpha < 1.0f || !textures.opaque[texIndex];
+        layer.retainedSpritesDirty = true;
+
+        return true;
+    }
+
+    static bool write_sprite_to_batch(RenderLayer& layer, const int texIndex, const Vec2D pos, const Rect& srcRect, const Vec2D origin, const float rot, const Vec2D scale, const float alpha) {
+        const int texUnit = prepare_sprite_batch_slot(layer, texIndex);
+        return texUnit != -1 && write_sprite_to_batch_slot(layer, texIndex, texUnit, pos, srcRect, origin, rot, scale, alpha);
+    }
+
+    static RectFloat get_sprite_cull_rect(const Camera& cam) {
+        return {get_camera_top_left(cam), to_vec_2d(get_camera_size(cam)) + Vec2D {1.0f, 1.0f}}; // Padded to make up for the camera size being truncated.
+    }
+
+    // Writes the recorded commands of a deferred layer to its batches ordered by sort key. The command indices are put through a stable LSD radix sort a byte at a time, so commands with equal keys keep their submission order. Passes over a byte that every key shares are skipped, which leaves one or two passes in the common case of few depths and textures.
+    static bool write_sprite_cmds_to_batches(RenderLayer& layer) {
+        static unsigned int l_sortKeys[2][gk_renderLayerSpriteCmdLimit];
+        static int l_sortIndices[2][gk_renderLayerSpriteCmdLimit];
+
+        const int cmdCnt = layer.spriteCmdCnt;
+
+        unsigned int* keys = l_sortKeys[0];
+        int* indices = l_sortIndices[0];
+        unsigned int* keysTemp = l_sortKeys[1];
+        int* indicesTemp = l_sortIndices[1];
+
+        for (int i = 0; i < cmdCnt; ++i) {
+            keys[i] = layer.spriteCmds[i].sortKey;
+            indices[i] = i;
+        }
+
+        for (int shift = 0; shift < 32; shift += 8) {
+            int digitOffsets[256] = {};
+
+            for (int i = 0; i < cmdCnt; ++i) {
+                ++digitOffsets[(keys[i] >> shift) & 0xFF];
+            }
+
+            if (digitOffsets[(keys[0] >> shift) & 0xFF] == cmdCnt) {
+                continue;
+            }
+
+            int offs = 0;
+
+            for (int i = 0; i < 256; ++i) {
+                const int digitCnt = digitOffsets[i];
+                digitOffsets[i] = offs;
+                offs += digitCnt;
+            }
+
+            for (int i = 0; i < cmdCnt; ++i) {
+                const int destIndex = digitOffsets[(keys[i] >> shift) & 0xFF]++;
+                keysTemp[destIndex] = keys[i];
+                indicesTemp[destIndex] = indices[i];
+            }
+
+            swap(keys, keysTemp);
+            swap(indices, indicesTemp);
+        }
+
+        layer.spriteCmdCnt = 0;
+
+        for (int i = 0; i < cmdCnt; ++i) {
+            const SpriteCmd& cmd = layer.spriteCmds[indices[i]];
+
+            if (!write_sprite_to_batch(layer, cmd.texIndex, cmd.pos, cmd.srcRect, cmd.origin, cmd.rot, cmd.scale, cmd.alpha)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Uploads the display properties of the active character batches of the layer, skipping the upload if none have changed. Returns whether any active batch has slots to draw.
+    static bool upload_char_batch_shader_props(RenderLayer& layer) {
+        bool anySlotsUsed = false;
+
+        int changedBegin = layer.charBatchCap;
+        int changedEnd = 0;
+
+        for (int i = 0; i < layer.charBatchCap; ++i) {
+            if (!is_bit_active(layer.charBatchActivity, i)) {
+                continue;
+            }
+
+            const CharBatch& batch = layer.charBatches[i];
+
+            anySlotsUsed |= batch.slotsUsed > 0;
+
+            const CharBatchShaderProps props = {
+                .pos = batch.displayProps.pos,
+                .rot = batch.displayProps.rot,
+                .blend = batch.displayProps.blend
+            };
+
+            if (memcmp(&props, &layer.charBatchShaderProps[i], sizeof(props)) != 0) {
+                layer.charBatchShaderProps[i] = props;
+                changedBegin = min(changedBegin, i);
+                changedEnd = i + 1;
+            }
+        }
+
+        if (changedBegin < changedEnd) {
+            glBindBuffer(GL_UNIFORM_BUFFER, layer.charBatchPropsUniBufGLID);
+            glBufferSubData(GL_UNIFORM_BUFFER, sizeof(CharBatchShaderProps) * changedBegin, sizeof(CharBatchShaderProps) * (changedEnd - changedBegin), &layer.charBatchShaderProps[changedBegin]);
+        }
+
+        return anySlotsUsed;
+    }
+
+    static bool are_merged_chars_stale(const RenderLayer& layer) {
+        if (layer.mergedCharsDirty) {
+            return true;
+        }
+
+        for (int i = 0; i < layer.charBatchCap; ++i) {
+            const CharBatch& batch = layer.charBatches[i];
+
+            if (is_bit_active(layer.charBatchActivity, i) && batch.slotsUsed > 0 && batch.displayProps.fontIndex != batch.mergedFontIndex) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Copies the used slots of the active character batches of the layer into its merged buffer on the GPU, grouped by font.
+    static void merge_char_batches(Renderer& renderer, RenderLayer& layer) {
+        zero_out(layer.mergedCharFontSlotCnts);
+
+        for (int i = 0; i < layer.charBatchCap; ++i) {
+            if (is_bit_active(layer.charBatchActivity, i)) {
+                const CharBatch& batch = layer.charBatches[i];
+                layer.mergedCharFontSlotCnts[batch.displayProps.fontIndex] += batch.slotsUsed;
+            }
+        }
+
+        int slotCnt = 0;
+
+        for (int i = 0; i < gk_fontLimit; ++i) {
+            layer.mergedCharFontSlotBegins[i] = slotCnt;
+            slotCnt += layer.mergedCharFontSlotCnts[i];
+        }
+
+        if (slotCnt > layer.mergedCharQuadBufSlotCnt) {
+            if (layer.mergedCharQuadBufSlotCnt > 0) {
+                glDeleteVertexArrays(1, &layer.mergedCharQuadBuf.vertArrayGLID);
+                glDeleteBuffers(1, &layer.mergedCharQuadBuf.vertBufGLID);
+            }
+
+            layer.mergedCharQuadBufSlotCnt = ceil_to_power_of_two(max(slotCnt, gk_charBatchSlotLimit));
+            layer.mergedCharQuadBuf = gen_char_quad_buf(layer.mergedCharQuadBufSlotCnt, renderer.quadElemBufGLID);
+        }
+
+        int fontSlotOffsets[gk_fontLimit];
+        memcpy(fontSlotOffsets, layer.mergedCharFontSlotBegins, sizeof(fontSlotOffsets));
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, layer.mergedCharQuadBuf.vertBufGLID);
+
+        for (int i = 0; i < layer.charBatchCap; ++i) {
+            if (!is_bit_active(layer.charBatchActivity, i)) {
+                continue;
+            }
+
+            CharBatch& batch = layer.charBatches[i];
+            const int fontIndex = batch.displayProps.fontIndex;
+
+            if (batch.slotsUsed > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, batch.quadBuf.vertBufGLID);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, ik_charBatchSlotVertsSize * fontSlotOffsets[fontIndex], ik_charBatchSlotVertsSize * batch.slotsUsed);
+                fontSlotOffsets[fontIndex] += batch.slotsUsed;
+            }
+
+            batch.mergedFontIndex = fontIndex;
+        }
+
+        layer.mergedCharsDirty = false;
+    }
+
+    // Uploads the used slots of all sprite batches of a retained layer into its own buffer back to back, orphaning what was there.
+    static void upload_retained_sprite_batches(Renderer& renderer, RenderLayer& layer) {
+        const int slotSize = get_sprite_batch_slot_size(layer);
+
+        int slotCnt = 0;
+
+        for (int i = 0; i < layer.spriteBatchCnt; ++i) {
+            slotCnt += layer.spriteBatchTransDatas[i].slotsUsed;
+        }
+
+        if (!layer.retainedVertBufGLID) {
+            glGenBuffers(1, &layer.retainedVertBufGLID);
+            layer.retainedVertArrayGLID = layer.instanced ? gen_sprite_inst_vert_array(layer.retainedVertBufGLID, renderer.spriteUnitQuadVertBufGLID) : gen_sprite_vert_array(layer.retainedVertBufGLID, renderer.quadElemBufGLID);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, layer.retainedVertBufGLID);
+        layer.retainedVertBufSize = slotSize * max(slotCnt, 1);
+        glBufferData(GL_ARRAY_BUFFER, layer.retainedVertBufSize, nullptr, GL_STATIC_DRAW);
+
+        int offs = 0;
+
+        for (int i = 0; i < layer.spriteBatchCnt; ++i) {
+            const int batchSize = slotSize * layer.spriteBatchTransDatas[i].slotsUsed;
+
+            if (batchSize > 0) {
+                glBufferSubData(GL_ARRAY_BUFFER, offs, batchSize, layer.spriteBatchSlots[i]);
+                offs += batchSize;
+            }
+        }
+
+        layer.retainedSpritesDirty = false;
+    }
+
+    static void clean_tilemap(Tilemap& tilemap) {
+        if (tilemap.chunks) {
+            for (int i = 0; i < tilemap.chunkCnts.x * tilemap.chunkCnts.y; ++i) {
+                const TilemapChunk& chunk = tilemap.chunks[i];
+
+                if (chunk.quadBuf.vertArrayGLID) {
+                    glDeleteVertexArrays(1, &chunk.quadBuf.vertArrayGLID);
+                    glDeleteBuffers(1, &chunk.quadBuf.vertBufGLID);
+                }
+            }
+        }
+
+        free(tilemap.tiles);
+        free(tilemap.chunks);
+
+        zero_out(tilemap);
+    }
+
+    // Returns the range of chunks to draw, which on camera layers is only those overlapping the camera view.
+    static Rect get_tilemap_chunk_range_to_draw(const Tilemap& tilemap, const Camera& cam, const bool cull) {
+        if (!cull) {
+            return {tilemap.chunkCnts.x, tilemap.chunkCnts.y};
+        }
+
+        const Vec2D chunkSize = to_vec_2d(tilemap.tileSize) * gk_tilemapChunkSize;
+        const RectFloat camRect = get_sprite_cull_rect(cam);
+
+        const int beginX = clamp(static_cast<int>(floorf((camRect.x - tilemap.pos.x) / chunkSize.x)), 0, tilemap.chunkCnts.x);
+        const int beginY = clamp(static_cast<int>(floorf((camRect.y - tilemap.pos.y) / chunkSize.y)), 0, tilemap.chunkCnts.y);
+        const int endX = clamp(static_cast<int>(ceilf((get_rect_right(camRect) - tilemap.pos.x) / chunkSize.x)), 0, tilemap.chunkCnts.x);
+        const int endY = clamp(static_cast<int>(ceilf((get_rect_bottom(camRect) - tilemap.pos.y) / chunkSize.y)), 0, tilemap.chunkCnts.y);
+
+        return {beginX, beginY, max(endX - beginX, 0), max(endY - beginY, 0)};
+    }
+
+    // Writes a slot for each set tile of the chunk and uploads them, orphaning what was in its buffer.
+    static void build_tilemap_chunk(Renderer& renderer, Tilemap& tilemap, const Pt2D chunkPos) {
+        static Byte l_slots[ik_spriteBatchSlotVertsSize * gk_tilemapChunkSize * gk_tilemapChunkSize];
+
+        TilemapChunk& chunk = tilemap.chunks[(chunkPos.y * tilemap.chunkCnts.x) + chunkPos.x];
+
+        const Textures& textures = get_assets().textures;
+        const Pt2D texSize = textures.glTexSizes[tilemap.texIndex];
+        const Pt2D texOffs = textures.glTexOffsets[tilemap.texIndex];
+        const int texUnit = get_sprite_tex_unit_val(textures, tilemap.texIndex, 0);
+        const int tilesetColCnt = textures.sizes[tilemap.texIndex].x / tilemap.tileSize.x;
+        const int tilesetRowCnt = textures.sizes[tilemap.texIndex].y / tilemap.tileSize.y;
+        assert(tilesetColCnt > 0 && tilesetRowCnt > 0); // Ensured by init_layer_tilemap.
+
+        const Pt2D tilesBegin = {chunkPos.x * gk_tilemapChunkSize, chunkPos.y * gk_tilemapChunkSize};
+        const Pt2D tilesEnd = {min(tilesBegin.x + gk_tilemapChunkSize, tilemap.size.x), min(tilesBegin.y + gk_tilemapChunkSize, tilemap.size.y)};
+
+        chunk.slotsUsed = 0;
+
+        for (int y = tilesBegin.y; y < tilesEnd.y; ++y) {
+            for (int x = tilesBegin.x; x < tilesEnd.x; ++x) {
+                const int tileIndex = tilemap.tiles[(y * tilemap.size.x) + x];
+
+                if (tileIndex == -1) {
+                    continue;
+                }
+
+                assert(tileIndex < tilesetColCnt * tilesetRowCnt);
+
+                const Vec2D pos = tilemap.pos + Vec2D {static_cast<float>(x * tilemap.tileSize.x), static_cast<float>(y * tilemap.tileSize.y)};
+
+                const Rect srcRect = {
+                    texOffs.x + ((tileIndex % tilesetColCnt) * tilemap.tileSize.x),
+                    texOffs.y + ((tileIndex / tilesetColCnt) * tilemap.tileSize.y),
+                    tilemap.tileSize.x,
+                    tilemap.tileSize.y
+                };
+
+                write_sprite_verts(l_slots + (chunk.slotsUsed * ik_spriteBatchSlotVertsSize), pos, srcRect, texSize, {}, 0.0f, {1.0f, 1.0f}, 1.0f, texUnit);
+                ++chunk.slotsUsed;
+            }
+        }
+
+        if (!chunk.quadBuf.vertArrayGLID) {
+            glGenBuffers(1, &chunk.quadBuf.vertBufGLID);
+            chunk.quadBuf.vertArrayGLID = gen_sprite_vert_array(chunk.quadBuf.vertBufGLID, renderer.quadElemBufGLID);
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.quadBuf.vertBufGLID);
+        glBufferData(GL_ARRAY_BUFFER, ik_spriteBatchSlotVertsSize * max(chunk.slotsUsed, 1), l_slots, GL_STATIC_DRAW);
+
+        chunk.dirty = false;
+    }
+
+    // Rebuilds the dirty chunks among those to be drawn, returning whether any were. Chunks out of view are left until they come into it.
+    static bool build_dirty_tilemap_chunks(Renderer& renderer, Tilemap& tilemap, const Rect& chunkRange) {
+        bool anyBuilt = false;
+
+        for (int y = chunkRange.y; y < get_rect_bottom(chunkRange); ++y) {
+            for (int x = chunkRange.x; x < get_rect_right(chunkRange); ++x) {
+                if (tilemap.chunks[(y * tilemap.chunkCnts.x) + x].dirty) {
+                    build_tilemap_chunk(renderer, tilemap, {x, y});
+                    anyBuilt = true;
+                }
+            }
+        }
+
+        return anyBuilt;
+    }
+
+    static Matrix4x4 create_cam_view_matrix(const Camera& cam) {
+        Matrix4x4 mat = {};
+        mat[0][0] = cam.scale;
+        mat[1][1] = cam.scale;
+        mat[3][3] = 1.0f;
+        mat[3][0] = (-cam.pos.x * cam.scale) + (get_window_size().x / 2.0f);
+        mat[3][1] = (-cam.pos.y * cam.scale) + (get_window_size().y / 2.0f);
+        return mat;
+    }
+
+    void clean_renderer(Renderer& renderer) {
+        for (int i = 0; i < gk_renderLayerLimit; ++i) {
+            RenderLayer& layer = renderer.layers[i];
+
+            clean_tilemap(layer.tilemap);
+
+            if (layer.retainedVertBufGLID) {
+                glDeleteVertexArrays(1, &layer.retainedVertArrayGLID);
+                glDeleteBuffers(1, &layer.retainedVertBufGLID);
+            }
+
+            for (int j = 0; j < layer.spriteBatchCnt; ++j) {
+                free(layer.spriteBatchSlots[j]);
+            }
+
+            free(layer.spriteBatchSlots);
+            free(layer.spriteBatchSlotCaps);
+            free(layer.spriteBatchTransDatas);
+            free(layer.spriteCmds);
+
+            for (int j = 0; j < layer.charBatchCap; ++j) {
+                if (is_bit_active(layer.charBatchActivity, j)) {
+                    delete_char_batch_buf(layer.charBatches[j].quadBuf, layer.charBatches[j].slotVerts);
+                }
+            }
+
+            free(layer.charBatches);
+            free(layer.charBatchShaderProps);
+            glDeleteBuffers(1, &layer.charBatchPropsUniBufGLID);
+
+            if (layer.mergedCharQuadBufSlotCnt > 0) {
+                glDeleteVertexArrays(1, &layer.mergedCharQuadBuf.vertArrayGLID);
+                glDeleteBuffers(1, &layer.mergedCharQuadBuf.vertBufGLID);
+            }
+        }
+
+        for (int i = 0; i < gk_charBatchBufSizeClassCnt; ++i) {
+            for (int j = 0; j < renderer.charBatchBufPool.freeBufCnts[i]; ++j) {
+                delete_char_batch_buf(renderer.charBatchBufPool.freeBufs[i][j], renderer.charBatchBufPool.freeBufSlotVerts[i][j]);
+            }
+        }
+
+        glDeleteVertexArrays(1, &renderer.spriteVertArrayGLID);
+        glDeleteVertexArrays(1, &renderer.spriteInstVertArrayGLID);
+        clean_ring_buf(renderer.vertRingBuf);
+
+        glDeleteBuffers(1, &renderer.spriteUnitQuadVertBufGLID);
+        glDeleteBuffers(1, &renderer.quadElemBufGLID);
+        glDeleteBuffers(1, &renderer.matricesUniBufGLID);
+
+        zero_out(renderer);
+    }
+
+    bool reset_renderer(Renderer& renderer, const int layerCnt, const int camLayerCnt, const Color bgColor, const Vec2D camPos, const float camScale) {
+        clean_renderer(renderer);
+
+        // Generate the unit quad used by instanced sprite batches, ordered for drawing as a triangle strip.
+        {
+            const Vec2D unitQuadVerts[] = {
+                {0.0f, 0.0f},
+                {1.0f, 0.0f},
+                {0.0f, 1.0f},
+                {1.0f, 1.0f}
+            };
+
+            glGenBuffers(1, &renderer.spriteUnitQuadVertBufGLID);
+            glBindBuffer(GL_ARRAY_BUFFER, renderer.spriteUnitQuadVertBufGLID);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(unitQuadVerts), unitQuadVerts, GL_STATIC_DRAW);
+        }
+
+        // Generate the element buffer shared by all sprite and character batches, enough for the largest batch.
+        {
+            static unsigned short l_quadIndices[6 * ik_quadElemBufQuadCnt];
+
+            for (int i = 0; i < ik_quadElemBufQuadCnt; i++) {
+                l_quadIndices[(i * 6) + 0] = (i * 4) + 0;
+                l_quadIndices[(i * 6) + 1] = (i * 4) + 1;
+                l_quadIndices[(i * 6) + 2] = (i * 4) + 2;
+                l_quadIndices[(i * 6) + 3] = (i * 4) + 2;
+                l_quadIndices[(i * 6) + 4] = (i * 4) + 3;
+                l_quadIndices[(i * 6) + 5] = (i * 4) + 0;
+            }
+
+            // Uploaded through the array buffer target, as the element buffer binding belongs to whichever vertex array is bound.
+            glGenBuffers(1, &renderer.quadElemBufGLID);
+            glBindBuffer(GL_ARRAY_BUFFER, renderer.quadElemBufGLID);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(l_quadIndices), l_quadIndices, GL_STATIC_DRAW);
+        }
+
+        // Generate the uniform buffer of the matrices shared by all programs, which is filled on the first render.
+        glGenBuffers(1, &renderer.matricesUniBufGLID);
+        glBindBuffer(GL_UNIFORM_BUFFER, renderer.matricesUniBufGLID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ShaderProgMatrices), nullptr, GL_DYNAMIC_DRAW);
+
+        if (!init_ring_buf(renderer.vertRingBuf, gk_vertRingBufRegionSize)) {
+            log_error("Failed to initialise the vertex ring buffer!");
+            return false;
+        }
+
+        // Generate the sprite vertex arrays, which all batches share since each is drawn from wherever it was written in the ring buffer.
+        renderer.spriteVertArrayGLID = gen_sprite_vert_array(renderer.vertRingBuf.glID, renderer.quadElemBufGLID);
+        renderer.spriteInstVertArrayGLID = gen_sprite_inst_vert_array(renderer.vertRingBuf.glID, renderer.spriteUnitQuadVertBufGLID);
+
+        renderer.layerCnt = layerCnt;
+        renderer.camLayerCnt = camLayerCnt;
+        renderer.bgColor = bgColor;
+        renderer.cam.pos = camPos;
+        renderer.cam.scale = camScale;
+
+        return true;
+    }
+
+    bool render_all(Renderer& renderer, const ShaderProgs& shaderProgs) {
+        glClearColor(renderer.bgColor.r, renderer.bgColor.g, renderer.bgColor.b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        GLStateCache& cache = renderer.glStateCache;
+        invalidate_gl_state_cache_bindings(cache);
+        cache.issuedCallCnt = 0;
+        cache.skippedCallCnt = 0;
+
+        // Upload the matrices only if the window has been resized or the camera has moved since they were last uploaded.
+        {
+            ShaderProgMatrices matrices;
+            matrices.proj = create_ortho_matrix_4x4(0.0f, get_window_size().x, get_window_size().y, 0.0f, -1.0f, 1.0f);
+            matrices.views[gk_shaderProgCamViewIndex] = create_cam_view_matrix(renderer.cam);
+            matrices.views[gk_shaderProgDefaultViewIndex] = create_identity_matrix_4x4();
+
+            glBindBuffer(GL_UNIFORM_BUFFER, renderer.matricesUniBufGLID);
+
+            if (memcmp(&matrices, &renderer.matrices, sizeof(matrices)) != 0) {
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), &matrices);
+                renderer.matrices = matrices;
+            }
+
+            glBindBufferBase(GL_UNIFORM_BUFFER, gk_shaderProgMatricesBinding, renderer.matricesUniBufGLID);
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.vertRingBuf.glID);
+
+        for (int i = 0; i < renderer.layerCnt; ++i) {
+            RenderLayer& layer = renderer.layers[i];
+
+            if (layer.spriteCmdCnt > 0 && !write_sprite_cmds_to_batches(layer)) {
+                return false;
+            }
+
+            if (layer.retained && layer.retainedSpritesDirty) {
+                upload_retained_sprite_batches(renderer, layer);
+                invalidate_gl_state_cache_bindings(cache); // The upload binds and unbinds objects.
+            }
+
+            const int viewIndex = i < renderer.camLayerCnt ? gk_shaderProgCamViewIndex : gk_shaderProgDefaultViewIndex;
+            const bool texArrays = get_assets().textures.inArrays;
+
+            // Render tilemap chunks.
+            if (layer.tilemap.tiles) {
+                Tilemap& tilemap = layer.tilemap;
+                const Rect chunkRange = get_tilemap_chunk_range_to_draw(tilemap, renderer.cam, i < renderer.camLayerCnt);
 
-    static constexpr int ik_charBatchSlotVertsCnt = gk_charQuadShaderProgVertCnt * 4;
-    static constexpr int ik_charBatchSlotVertsSize = sizeof(float) * ik_charBatchSlotVertsCnt;
+                if (build_dirty_tilemap_chunks(renderer, tilemap, chunkRange)) {
+                    invalidate_gl_state_cache_bindings(cache); // Building chunks binds and unbinds objects.
+                }
 
-    static QuadBuf gen_quad_buf(const int quadCnt, const bool sprite) {
-        assert(quadCnt > 0);
+                // Tiles are never rotated, and skip blending if the tileset is opaque.
+                const int variant = gk_spriteQuadShaderProgNoRotFlag | (get_assets().textures.opaque[tilemap.texIndex] ? gk_spriteQuadShaderProgOpaqueFlag : 0);
+                use_sprite_shader_prog(cache, shaderProgs.spriteQuad[variant], viewIndex);
+                set_blend_enabled(cache, !(variant & gk_spriteQuadShaderProgOpaqueFlag));
+                bind_tex_to_unit(cache, 0, texArrays ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, get_assets().textures.glIDs[tilemap.texIndex]);
+
+                for (int y = chunkRange.y; y < get_rect_bottom(chunkRange); ++y) {
+                    for (int x = chunkRange.x; x < get_rect_right(chunkRange); ++x) {
+                        const TilemapChunk& chunk = tilemap.chunks[(y * tilemap.chunkCnts.x) + x];
+
+                        if (chunk.slotsUsed > 0) {
+                            bind_vert_array(cache, chunk.quadBuf.vertArrayGLID);
+                            glDrawElements(GL_TRIANGLES, 6 * chunk.slotsUsed, GL_UNSIGNED_SHORT, nullptr);
+                        }
+                    }
+                }
+            }
 
-        QuadBuf buf = {};
+            // Render sprite batches.
+            const SpriteQuadShaderProg* const spriteProgVariants = layer.instanced ? shaderProgs.spriteQuadInst : shaderProgs.spriteQuad;
 
-        const int vertCnt = sprite ? gk_spriteQuadShaderProgVertCnt : gk_charQuadShaderProgVertCnt;
+            const int slotSize = get_sprite_batch_slot_size(layer);
+            const int vertsStride = layer.instanced ? ik_spriteBatchSlotInstSize : ik_spriteVertsStride;
 
-        // Generate vertex array.
-        glGenVertexArrays(1, &buf.vertArrayGLID);
-        glBindVertexArray(buf.vertArrayGLID);
+            int retainedBufOffs = 0;
 
-        // Generate vertex buffer.
-        glGenBuffers(1, &buf.vertBufGLID);
-        glBindBuffer(GL_ARRAY_BUFFER, buf.vertBufGLID);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertCnt * 4 * quadCnt, nullptr, GL_DYNAMIC_DRAW);
+            // Consecutive batches that can share texture bindings are collected and drawn together.
+            static SpriteBatchDraws l_draws;
+            l_draws.cnt = 0;
 
-        // Generate element buffer.
-        {
-            static constexpr int lk_quadLimit = max(gk_spriteBatchSlotLimit, gk_charBatchSlotLimit);
-            static constexpr int lk_quadIndicesLen = 6 * lk_quadLimit;
-            static unsigned short l_quadIndices[lk_quadIndicesLen];
-            static bool l_quadIndicesInitialized = false;
-
-            if (!l_quadIndicesInitialized) {
-                for (int i = 0; i < lk_quadLimit; i++) {
-                    l_quadIndices[(i * 6) + 0] = (i * 4) + 0;
-                    l_quadIndices[(i * 6) + 1] = (i * 4) + 1;
-                    l_quadIndices[(i * 6) + 2] = (i * 4) + 2;
-                    l_quadIndices[(i * 6) + 3] = (i * 4) + 2;
-                    l_quadIndices[(i * 6) + 4] = (i * 4) + 3;
-                    l_quadIndices[(i * 6) + 5] = (i * 4) + 0;
+            for (int j = 0; j < layer.spriteBatchCnt; ++j) {
+                SpriteBatchTransData* const batchTransData = &layer.spriteBatchTransDatas[j];
+
+                if (batchTransData->slotsUsed == 0) {
+                    continue;
+                }
+
+                if (l_draws.cnt == ik_spriteBatchDrawLimit || (l_draws.cnt > 0 && !can_sprite_batches_share_draw(l_draws.texData, *batchTransData))) {
+                    if (!submit_sprite_batch_draws(renderer, l_draws, spriteProgVariants, viewIndex, layer.instanced)) {
+                        return false;
+                    }
+                }
+
+                const int batchSize = slotSize * batchTransData->slotsUsed;
+
+                // Draw the batch from where it is in the retained buffer, or otherwise stream it into the ring buffer at a multiple of the vertex or instance stride so that it can be drawn from there by base vertex or instance. A batch is left as it was streamed if unchanged, as it is across frames rendered between ticks.
+                int bufOffs;
+
+                if (layer.retained) {
+                    bufOffs = retainedBufOffs;
+                    retainedBufOffs += batchSize;
+
+                    bind_vert_array(cache, layer.retainedVertArrayGLID);
+                } else {
+                    RingBufRange& streamedRange = batchTransData->streamedRange;
+
+                    if (streamedRange.size != batchSize || !reuse_ring_buf_range(renderer.vertRingBuf, streamedRange)) {
+                        if (!write_to_ring_buf(renderer.vertRingBuf, streamedRange, layer.spriteBatchSlots[j], batchSize, vertsStride)) {
+                            return false;
+                        }
+                    }
+
+                    bufOffs = streamedRange.offs;
+
+                    bind_vert_array(cache, layer.instanced ? renderer.spriteInstVertArrayGLID : renderer.spriteVertArrayGLID);
                 }
 
-                l_quadIndicesInitialized = true;
+                add_sprite_batch_draw(l_draws, *batchTransData, bufOffs / vertsStride, layer.instanced);
             }
 
-            glGenBuffers(1, &buf.elemBufGLID);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf.elemBufGLID);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * 6 * quadCnt, l_quadIndices, GL_STATIC_DRAW);
-        }
+            if (!submit_sprite_batch_draws(renderer, l_draws, spriteProgVariants, viewIndex, layer.instanced)) {
+                return false;
+            }
 
-        // Set vertex attribute pointers.
-        const int vertsStride = sizeof(float) * vertCnt;
+            // Render character batches.
+            if (!upload_char_batch_shader_props(layer)) {
+                continue;
+            }
+
+            use_shader_prog(cache, shaderProgs.charQuad.glID);
+            set_blend_enabled(cache, true);
 
-        if (sprite) {
-            glVertexAttribPointer(0, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 0));
-            glEnableVertexAttribArray(0);
+            set_uniform_ints(cache, shaderProgs.charQuad.viewIndexUniLoc, &viewIndex, 1);
 
-            glVertexAttribPointer(1, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 2));
-            glEnableVertexAttribArray(1);
+            glBindBufferBase(GL_UNIFORM_BUFFER, gk_charQuadShaderProgBatchPropsBinding, layer.charBatchPropsUniBufGLID);
 
-            glVertexAttribPointer(2, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 4));
-            glEnableVertexAttribArray(2);
+            if (layer.charBatchesMerged) {
+                if (are_merged_chars_stale(layer)) {
+                    merge_char_batches(renderer, layer);
+                    invalidate_gl_state_cache_bindings(cache); // Growing the merged buffer binds and unbinds objects.
+                }
 
-            glVertexAttribPointer(3, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 6));
-            glEnableVertexAttribArray(3);
+                bind_vert_array(cache, layer.mergedCharQuadBuf.vertArrayGLID);
 
-            glVertexAttribPointer(4, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 7));
-            glEnableVertexAttribArray(4);
+                for (int j = 0; j < gk_fontLimit; ++j) {
+                    const int fontSlotCnt = layer.mergedCharFontSlotCnts[j];
 
-            glVertexAttribPointer(5, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 8));
-            glEnableVertexAttribArray(5);
+                    if (fontSlotCnt == 0) {
+                        continue;
+                    }
 
-            glVertexAttribPointer(6, 1, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 10));
-            glEnableVertexAttribArray(6);
-        } else {
-            glVertexAttribPointer(0, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 0));
-            glEnableVertexAttribArray(0);
+                    bind_tex_to_unit(cache, 0, GL_TEXTURE_2D, get_assets().fonts.texGLIDs[j]);
+
+                    // The shared element buffer only indexes so many quads, so larger runs are drawn in pieces offset by base vertex.
+                    for (int k = 0; k < fontSlotCnt; k += ik_quadElemBufQuadCnt) {
+                        const int slotCnt = min(fontSlotCnt - k, ik_quadElemBufQuadCnt);
+                        glDrawElementsBaseVertex(GL_TRIANGLES, 6 * slotCnt, GL_UNSIGNED_SHORT, nullptr, 4 * (layer.mergedCharFontSlotBegins[j] + k));
+                    }
+                }
+            } else {
+                for (int j = 0; j < layer.charBatchCap; ++j) {
+                    if (!is_bit_active(layer.charBatchActivity, j)) {
+                        continue;
+                    }
+
+                    const CharBatch* const batch = &layer.charBatches[j];
+
+                    if (batch->slotsUsed == 0) {
+                        continue;
+                    }
+
+                    bind_tex_to_unit(cache, 0, GL_TEXTURE_2D, get_assets().fonts.texGLIDs[batch->displayProps.fontIndex]);
 
-            glVertexAttribPointer(1, 2, GL_FLOAT, false, vertsStride, reinterpret_cast<void*>(sizeof(float) * 2));
-            glEnableVertexAttribArray(1);
+                    bind_vert_array(cache, batch->quadBuf.vertArrayGLID);
+                    glDrawElements(GL_TRIANGLES, 6 * batch->slotsUsed, GL_UNSIGNED_SHORT, nullptr);
+                }
+            }
         }
 
-        glBindVertexArray(0);
+        fence_ring_buf(renderer.vertRingBuf);
 
-        return buf;
+        return true;
     }
 
-    static int add_tex_unit_to_sprite_batch(SpriteBatchTransData& batchTransData, const int texIndex) {
-        for (int i = 0; i < batchTransData.texUnitsInUse; ++i) {
-            if (batchTransData.texUnitTexIDs[i] == texIndex) {
-                return i;
+    RenderLayerMemUsage get_render_layer_mem_usage(const Renderer& renderer, const int layerIndex) {
+        assert(layerIndex >= 0 && layerIndex < gk_renderLayerLimit);
+
+        const RenderLayer& layer = renderer.layers[layerIndex];
+
+        RenderLayerMemUsage usage = {};
+
+        usage.spriteBatchBytes = ((sizeof(*layer.spriteBatchSlots) + sizeof(*layer.spriteBatchSlotCaps) + sizeof(*layer.spriteBatchTransDatas)) * layer.spriteBatchCap)
+            + (sizeof(*layer.spriteCmds) * layer.spriteCmdCap);
+
+        for (int i = 0; i < layer.spriteBatchCnt; ++i) {
+            usage.spriteBatchBytes += get_sprite_batch_slot_size(layer) * layer.spriteBatchSlotCaps[i];
+        }
+
+        usage.charBatchBytes = (sizeof(*layer.charBatches) + sizeof(*layer.charBatchShaderProps)) * layer.charBatchCap;
+
+        for (int i = 0; i < layer.charBatchCap; ++i) {
+            if (is_bit_active(layer.charBatchActivity, i)) {
+                const int bufSize = ik_charBatchSlotVertsSize * (gk_charBatchBufMinSlotCnt << layer.charBatches[i].bufSizeClass);
+                usage.charBatchBytes += bufSize; // The CPU-side copy.
+                usage.glBufBytes += bufSize;
             }
         }
 
-        if (batchTransData.texUnitsInUse == gk_texUnitLimit) {
-            return -1;
+        if (layer.charBatchPropsUniBufGLID) {
+            usage.glBufBytes += sizeof(CharBatchShaderProps) * gk_renderLayerCharBatchLimit;
         }
 
-        batchTransData.texUnitTexIDs[batchTransData.texUnitsInUse] = texIndex;
+        usage.glBufBytes += ik_charBatchSlotVertsSize * layer.mergedCharQuadBufSlotCnt;
+        usage.glBufBytes += layer.retainedVertBufSize;
 
-        return batchTransData.texUnitsInUse++;
-    }
+        const Tilemap& tilemap = layer.tilemap;
 
-    static Matrix4x4 create_cam_view_matrix(const Camera& cam) {
-        Matrix4x4 mat = {};
-        mat[0][0] = cam.scale;
-        mat[1][1] = cam.scale;
-        mat[3][3] = 1.0f;
-        mat[3][0] = (-cam.pos.x * cam.scale) + (get_window_size().x / 2.0f);
-        mat[3][1] = (-cam.pos.y * cam.scale) + (get_window_size().y / 2.0f);
-        return mat;
-    }
+        if (tilemap.tiles) {
+            const int chunkCnt = tilemap.chunkCnts.x * tilemap.chunkCnts.y;
 
-    void clean_renderer(Renderer& renderer) {
-        for (int i = 0; i < renderer.layerCnt; ++i) {
-            RenderLayer& layer = renderer.layers[i];
+            usage.tilemapBytes = (sizeof(*tilemap.tiles) * tilemap.size.x * tilemap.size.y) + (sizeof(*tilemap.chunks) * chunkCnt);
 
-            for (int j = 0; j < layer.spriteBatchCnt; ++j) {
-                glDeleteVertexArrays(1, &layer.spriteBatchQuadBufs[j].vertArrayGLID);
-                glDeleteBuffers(1, &layer.spriteBatchQuadBufs[j].vertBufGLID);
-                glDeleteBuffers(1, &layer.spriteBatchQuadBufs[j].elemBufGLID);
+            for (int i = 0; i < chunkCnt; ++i) {
+                if (tilemap.chunks[i].quadBuf.vertBufGLID) {
+                    usage.glBufBytes += ik_spriteBatchSlotVertsSize * max(tilemap.chunks[i].slotsUsed, 1);
+                }
             }
         }
 
-        zero_out(renderer);
+        return usage;
     }
 
-    void reset_renderer(Renderer& renderer, const int layerCnt, const int camLayerCnt, const Color bgColor, const Vec2D camPos, const float camScale) {
-        clean_renderer(renderer);
-        renderer.layerCnt = layerCnt;
-        renderer.camLayerCnt = camLayerCnt;
-        renderer.bgColor = bgColor;
-        renderer.cam.pos = camPos;
-        renderer.cam.scale = camScale;
+    void empty_sprite_batches(Renderer& renderer) {
+        for (int i = 0; i < renderer.layerCnt; ++i) {
+            if (!renderer.layers[i].retained) {
+                empty_sprite_layer(renderer, i);
+            }
+        }
     }
 
-    void render_all(const Renderer& renderer, const ShaderProgs& shaderProgs) {
-        glClearColor(renderer.bgColor.r, renderer.bgColor.g, renderer.bgColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+    void empty_sprite_layer(Renderer& renderer, const int layerIndex) {
+        assert(layerIndex >= 0 && layerIndex < renderer.layerCnt);
 
-        static int lk_texUnits[gk_texUnitLimit];
-        static bool lk_texUnitsInitialized = false;
+        RenderLayer& layer = renderer.layers[layerIndex];
+        memset(layer.spriteBatchTransDatas, 0, sizeof(*layer.spriteBatchTransDatas) * layer.spriteBatchCap);
+        layer.spriteBatchesFilled = 0;
+        layer.spriteCmdCnt = 0;
+        layer.culledSpriteCnt = 0;
+        layer.drawnSpriteCnt = 0;
+        layer.retainedSpritesDirty = true;
+    }
 
-        if (!lk_texUnitsInitialized) {
-            for (int i = 0; i < gk_texUnitLimit; ++i) {
-                lk_texUnits[i] = i;
+    bool write_to_sprite_batch(Renderer& renderer, const int layerIndex, const int texIndex, const Vec2D pos, const Rect& srcRect, const Vec2D origin, const float rot, const Vec2D scale, const float alpha, const int depth) {
+        assert(layerIndex >= 0 && layerIndex < renderer.layerCnt);
+        assert(depth >= 0 && depth < gk_spriteDepthLimit);
+
+        RenderLayer& layer = renderer.layers[layerIndex];
+
+        if (layerIndex < renderer.camLayerCnt && !layer.retained) {
+            const Vec2D size = {srcRect.width * scale.x, srcRect.height * scale.y};
+
+            if (!do_rects_intersect(calc_sprite_bounds(pos, size, origin, rot), get_sprite_cull_rect(renderer.cam))) {
+                ++layer.culledSpriteCnt;
+                return true;
             }
+        }
 
-            lk_texUnitsInitialized = true;
+        if (layer.deferred && layer.spriteCmdCnt == gk_renderLayerSpriteCmdLimit) {
+            log_error("Failed to record a sprite command as the layer has reached the limit of %d!", gk_renderLayerSpriteCmdLimit);
+            return false;
         }
 
-        const Matrix4x4 projMat = create_ortho_matrix_4x4(0.0f, get_window_size().x, get_window_size().y, 0.0f, -1.0f, 1.0f);
-        const Matrix4x4 camViewMat = create_cam_view_matrix(renderer.cam);
-        const Matrix4x4 defaultViewMat = create_identity_matrix_4x4();
+        ++layer.drawnSpriteCnt;
 
-        for (int i = 0; i < renderer.layerCnt; ++i) {
-            // Render sprite batches.
-            glUseProgram(shaderProgs.spriteQuad.glID);
+        if (!layer.deferred) {
+            return write_sprite_to_batch(layer, texIndex, pos, srcRect, origin, rot, scale, alpha);
+        }
 
-            glUniformMatrix4fv(shaderProgs.spriteQuad.projUniLoc, 1, false, reinterpret_cast<const float*>(projMat.elems));
+        if (layer.spriteCmdCnt == layer.spriteCmdCap) {
+            const int cap = min(max(layer.spriteCmdCap * 2, ik_spriteCmdMinCap), gk_renderLayerSpriteCmdLimit);
 
-            const Matrix4x4* const viewMat = i < renderer.camLayerCnt ? &camViewMat : &defaultViewMat;
-            glUniformMatrix4fv(shaderProgs.spriteQuad.viewUniLoc, 1, false, reinterpret_cast<const float*>(viewMat->elems));
+            const auto cmds = realloc_zeroed(layer.spriteCmds, layer.spriteCmdCap, cap);
 
-            glUniform1iv(shaderProgs.spriteQuad.texturesUniLoc, gk_texUnitLimit, lk_texUnits);
+            if (!cmds) {
+                log_error("Failed to allocate memory for sprite commands!");
+                return false;
+            }
 
-            const RenderLayer& layer = renderer.layers[i];
+            layer.spriteCmds = cmds;
+            layer.spriteCmdCap = cap;
+        }
 
-            for (int j = 0; j < layer.spriteBatchCnt; ++j) {
-                const QuadBuf* const batchQuadBuf = &layer.spriteBatchQuadBufs[j];
-                const SpriteBatchTransData* const batchTransData = &layer.spriteBatchTransDatas[j];
+        layer.spriteCmds[layer.spriteCmdCnt] = {
+            .sortKey = (static_cast<unsigned int>(depth) << 16) | static_cast<unsigned int>(get_assets().textures.uniqueGLIDIndices[texIndex]),
+            .texIndex = texIndex,
+            .pos = pos,
+            .srcRect = srcRect,
+            .origin = origin,
+            .rot = rot,
+            .scale = scale,
+            .alpha = alpha
+        };
 
-                glBindVertexArray(batchQuadBuf->vertArrayGLID);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batchQuadBuf->elemBufGLID);
+        ++layer.spriteCmdCnt;
 
-                for (int k = 0; k < batchTransData->texUnitsInUse; ++k) {
-                    glActiveTexture(GL_TEXTURE0 + k);
-                    glBindTexture(GL_TEXTURE_2D, get_assets().textures.glIDs[batchTransData->texUnitTexIDs[k]]);
-                }
+        return true;
+    }
+
+    // Does the same as calling write_to_sprite_batch for each sprite in turn, but with the camera bounds and texture unit of a run of sprites sharing a texture looked up once, which suits particles and crowds.
+    bool write_sprites_to_batch(Renderer& renderer, const int layerIndex, const SpriteInstance* const sprites, const int cnt, const int depth) {
+        assert(layerIndex >= 0 && layerIndex < renderer.layerCnt);
+        assert(cnt >= 0);
 
-                glDrawElements(GL_TRIANGLES, 6 * batchTransData->slotsUsed, GL_UNSIGNED_SHORT, nullptr);
+        RenderLayer& layer = renderer.layers[layerIndex];
+
+        // Deferred layers need every sprite recorded as a command for sorting, which gains nothing from being done in bulk.
+        if (layer.deferred) {
+            for (int i = 0; i < cnt; ++i) {
+                const SpriteInstance& sprite = sprites[i];
+
+                if (!write_to_sprite_batch(renderer, layerIndex, sprite.texIndex, sprite.pos, sprite.srcRect, sprite.origin, sprite.rot, sprite.scale, sprite.alpha, depth)) {
+                    return false;
+                }
             }
 
-            // Render character batches.
-            glUseProgram(shaderProgs.charQuad.glID);
+            return true;
+        }
+
+        const bool cull = layerIndex < renderer.camLayerCnt && !layer.retained;
+        const RectFloat cullRect = cull ? get_sprite_cull_rect(renderer.cam) : RectFloat {};
+
+        int runTexIndex = -1; // The texture of the current run of sprites, for which a batch slot does not need to be prepared again while the batch has room.
+        int runTexUnit = 0;
 
-            glUniformMatrix4fv(shaderProgs.charQuad.projUniLoc, 1, false, reinterpret_cast<const float*>(projMat.elems));
-            glUniformMatrix4fv(shaderProgs.charQuad.viewUniLoc, 1, false, reinterpret_cast<const float*>(viewMat->elems));
+        for (int i = 0; i < cnt; ++i) {
+            const SpriteInstance& sprite = sprites[i];
 
-            for (int j = 0; j < gk_renderLayerCharBatchLimit; ++j) {
-                if (!is_bit_active(layer.charBatchActivity, j)) {
+            if (cull) {
+                const Vec2D size = {sprite.srcRect.width * sprite.scale.x, sprite.srcRect.height * sprite.scale.y};
+
+                if (!do_rects_intersect(calc_sprite_bounds(sprite.pos, size, sprite.origin, sprite.rot), cullRect)) {
+                    ++layer.culledSpriteCnt;
                     continue;
                 }
+            }
 
-                const CharBatch* const batch = &layer.charBatches[j];
+            ++layer.drawnSpriteCnt;
 
-                glUniform2fv(shaderProgs.charQuad.posUniLoc, 1, reinterpret_cast<const float*>(&batch->displayProps.pos));
-                glUniform1f(shaderProgs.charQuad.rotUniLoc, batch->displayProps.rot);
-                glUniform4fv(shaderProgs.charQuad.blendUniLoc, 1, reinterpret_cast<const float*>(&batch->displayProps.blend));
+            if (sprite.texIndex != runTexIndex || layer.spriteBatchTransDatas[layer.spriteBatchesFilled].slotsUsed == gk_spriteBatchSlotLimit) {
+                runTexUnit = prepare_sprite_batch_slot(layer, sprite.texIndex);
 
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, get_assets().fonts.texGLIDs[batch->displayProps.fontIndex]);
+                if (runTexUnit == -1) {
+                    return false;
+                }
 
-                glBindVertexArray(batch->quadBuf.vertArrayGLID);
-                glDrawElements(GL_TRIANGLES, 6 * batch->slotCnt, GL_UNSIGNED_SHORT, nullptr);
+                runTexIndex = sprite.texIndex;
             }
-        }
-    }
 
-    void empty_sprite_batches(Renderer& renderer) {
-        for (int i = 0; i < renderer.layerCnt; ++i) {
-            RenderLayer& layer = renderer.layers[i];
-            zero_out(layer.spriteBatchTransDatas);
-            layer.spriteBatchesFilled = 0;
+            if (!write_sprite_to_batch_slot(layer, sprite.texIndex, runTexUnit, sprite.pos, sprite.srcRect, sprite.origin, sprite.rot, sprite.scale, sprite.alpha)) {
+                return false;
+            }
         }
+
+        return true;
     }
 
-    void write_to_sprite_batch(Renderer& renderer, const int layerIndex, const int texIndex, const Vec2D pos, const Rect& srcRect, const Vec2D origin, const float rot, const Vec2D scale, const float alpha) {
+    // Writes the sprites batch by batch, with the texture unit looked up once per batch and slots written straight from the arrays.
+    bool write_sprite_arrays_to_batch(Renderer& renderer, const int layerIndex, const SpriteArrays& sprites, const int depth) {
         assert(layerIndex >= 0 && layerIndex < renderer.layerCnt);
+        assert(sprites.cnt >= 0);
 
         RenderLayer& layer = renderer.layers[layerIndex];
 
-        if (layer.spriteBatchCnt == 0) {
-            layer.spriteBatchQuadBufs[layer.spriteBatchCnt] = gen_quad_buf(gk_spriteBatchSlotLimit, true);
-            ++layer.spriteBatchCnt;
+        if (layer.deferred) {
+            for (int i = 0; i < sprites.cnt; ++i) {
+                if (!write_to_sprite_batch(renderer, layerIndex, sprites.texIndex, {sprites.posXs[i], sprites.posYs[i]}, sprites.srcRect, sprites.origin, sprites.rots[i], sprites.scale, sprites.alphas[i], depth)) {
+                    return false;
+                }
+            }
+
+            return true;
         }
 
-        const int batchIndex = layer.spriteBatchesFilled;
-        SpriteBatchTransData& batchTransData = layer.spriteBatchTransDatas[batchIndex];
+        const bool cull = layerIndex < renderer.camLayerCnt && !layer.retained;
+        const RectFloat cullRect = cull ? get_sprite_cull_rect(renderer.cam) : RectFloat {};
+        const Vec2D size = {sprites.srcRect.width * sprites.scale.x, sprites.srcRect.height * sprites.scale.y};
 
-        int texUnit;
+        int i = 0;
 
-        if (batchTransData.slotsUsed == gk_spriteBatchSlotLimit || (texUnit = add_tex_unit_to_sprite_batch(batchTransData, texIndex)) == -1) {
-            ++layer.spriteBatchesFilled;
+        while (i < sprites.cnt) {
+            const int texUnit = prepare_sprite_batch_slot(layer, sprites.texIndex);
 
-            if (layer.spriteBatchesFilled == layer.spriteBatchCnt) {
-                layer.spriteBatchQuadBufs[layer.spriteBatchCnt] = gen_quad_buf(gk_spriteBatchSlotLimit, true);
-                ++layer.spriteBatchCnt;
+            if (texUnit == -1) {
+                return false;
             }
 
-            write_to_sprite_batch(renderer, layerIndex, texIndex, pos, srcRect, origin, rot, scale, alpha);
-            return;
+            const int batchSlotsLeft = gk_spriteBatchSlotLimit - layer.spriteBatchTransDatas[layer.spriteBatchesFilled].slotsUsed;
+            const int batchEnd = min(i + batchSlotsLeft, sprites.cnt);
+
+            for (; i < batchEnd; ++i) {
+                const Vec2D pos = {sprites.posXs[i], sprites.posYs[i]};
+
+                if (cull && !do_rects_intersect(calc_sprite_bounds(pos, size, sprites.origin, sprites.rots[i]), cullRect)) {
+                    ++layer.culledSpriteCnt;
+                    continue;
+                }
+
+                if (!write_sprite_to_batch_slot(layer, sprites.texIndex, texUnit, pos, sprites.srcRect, sprites.origin, sprites.rots[i], sprites.scale, sprites.alphas[i])) {
+                    return false;
+                }
+
+                ++layer.drawnSpriteCnt;
+            }
         }
 
-        const int slotIndex = batchTransData.slotsUsed;
+        return true;
+    }
+
+    bool init_layer_tilemap(Renderer& renderer, const int layerIndex, const int texIndex, const Pt2D size, const Pt2D tileSize, const Vec2D pos) {
+        assert(layerIndex >= 0 && layerIndex < renderer.layerCnt);
+        assert(size.x > 0 && size.y > 0);
+        assert(texIndex >= 0 && texIndex < get_assets().textures.cnt);
+
+        // The tileset must fit at least one tile, as tile indexes are mapped to columns and rows of it.
         const Pt2D texSize = get_assets().textures.sizes[texIndex];
 
-        const float verts[] = {
-            (0.0f - origin.x) * scale.x,
-            (0.0f - origin.y) * scale.y,
-            pos.x,
-            pos.y,
-            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
-            rot,
-            static_cast<float>(texUnit),
-            static_cast<float>(srcRect.x) / texSize.x, static_cast<float>(srcRect.y) / texSize.y,
-            alpha,
+        if (tileSize.x <= 0 || tileSize.y <= 0) {
+            log_error("Invalid tilemap tile size of %dx%d!", tileSize.x, tileSize.y);
+            return false;
+        }
 
-            (1.0f - origin.x) * scale.x,
-            (0.0f - origin.y) * scale.y,
-            pos.x,
-            pos.y,
-            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
-            rot,
-            static_cast<float>(texUnit),
-            static_cast<float>(srcRect.x + srcRect.width) / texSize.x,
-            static_cast<float>(srcRect.y) / texSize.y,
-            alpha,
+        if (tileSize.x > texSize.x || tileSize.y > texSize.y) {
+            log_error("Tilemap tile size of %dx%d is larger than its %dx%d tileset texture!", tileSize.x, tileSize.y, texSize.x, texSize.y);
+            return false;
+        }
 
-            (1.0f - origin.x) * scale.x,
-            (1.0f - origin.y) * scale.y,
-            pos.x,
-            pos.y,
-            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
-            rot,
-            static_cast<float>(texUnit),
-            static_cast<float>(srcRect.x + srcRect.width) / texSize.x,
-            static_cast<float>(srcRect.y + srcRect.height) / texSize.y,
-            alpha,
+        Tilemap& tilemap = renderer.layers[layerIndex].tilemap;
 
-            (0.0f - origin.x) * scale.x,
-            (1.0f - origin.y) * scale.y,
-            pos.x,
-            pos.y,
-            static_cast<float>(srcRect.width), static_cast<float>(srcRect.height),
-            rot,
-            static_cast<float>(texUnit),
-            static_cast<float>(srcRect.x) / texSize.x,
-            static_cast<float>(srcRect.y + srcRect.height) / texSize.y,
-            alpha
-        };
+        clean_tilemap(tilemap);
 
-        const QuadBuf* const batchQuadBuf = &layer.spriteBatchQuadBufs[batchIndex];
-        glBindVertexArray(batchQuadBuf->vertArrayGLID);
-        glBindBuffer(GL_ARRAY_BUFFER, batchQuadBuf->vertBufGLID);
-        glBufferSubData(GL_ARRAY_BUFFER, slotIndex * sizeof(float) * ik_spriteBatchSlotVertCnt, sizeof(verts), verts);
+        tilemap.texIndex = texIndex;
+        tilemap.tileSize = tileSize;
+        tilemap.size = size;
+        tilemap.pos = pos;
+        tilemap.chunkCnts = {(size.x + gk_tilemapChunkSize - 1) / gk_tilemapChunkSize, (size.y + gk_tilemapChunkSize - 1) / gk_tilemapChunkSize};
 
-        ++batchTransData.slotsUsed;
+        tilemap.tiles = alloc<int>(size.x * size.y);
+
+        if (!tilemap.tiles) {
+            log_error("Failed to allocate memory for tilemap tiles!");
+            clean_tilemap(tilemap);
+            return false;
+        }
+
+        memset(tilemap.tiles, -1, sizeof(*tilemap.tiles) * size.x * size.y);
+
+        tilemap.chunks = alloc_zeroed<TilemapChunk>(tilemap.chunkCnts.x * tilemap.chunkCnts.y);
+
+        if (!tilemap.chunks) {
+            log_error("Failed to allocate memory for tilemap chunks!");
+            clean_tilemap(tilemap);
+            return false;
+        }
+
+        return true;
+    }
+
+    void set_tilemap_tile(Renderer& renderer, const int layerIndex, const Pt2D tilePos, const int tileIndex) {
+        Tilemap& tilemap = renderer.layers[layerIndex].tilemap;
+
+        assert(tilemap.tiles);
+        assert(tilePos.x >= 0 && tilePos.x < tilemap.size.x && tilePos.y >= 0 && tilePos.y < tilemap.size.y);
+        assert(tileIndex >= -1);
+
+        int& tile = tilemap.tiles[(tilePos.y * tilemap.size.x) + tilePos.x];
+
+        if (tile != tileIndex) {
+            tile = tileIndex;
+            tilemap.chunks[((tilePos.y / gk_tilemapChunkSize) * tilemap.chunkCnts.x) + (tilePos.x / gk_tilemapChunkSize)].dirty = true;
+        }
     }
 
-    CharBatchID activate_any_char_batch(Renderer& renderer, const int layerIndex, const int slotCnt, const int fontIndex, const Vec2D pos) {
+    bool activate_any_char_batch(Renderer& renderer, const int layerIndex, const int slotCnt, const int fontIndex, const Vec2D pos, CharBatchID& id) {
         assert(layerIndex >= 0 && layerIndex < gk_renderLayerLimit);
-        assert(slotCnt > 0);
+        assert(slotCnt > 0 && slotCnt <= gk_charBatchSlotLimit);
 
         RenderLayer& layer = renderer.layers[layerIndex];
 
         const int batchIndex = get_first_inactive_bit_index(layer.charBatchActivity);
-        assert(batchIndex != -1);
+
+        if (batchIndex == -1) {
+            log_error("Failed to activate a character batch as the layer has reached the limit of %d!", gk_renderLayerCharBatchLimit);
+            return false;
+        }
+
+        if (batchIndex == layer.charBatchCap) {
+            const int cap = min(max(layer.charBatchCap * 2, ik_charBatchMinCap), gk_renderLayerCharBatchLimit);
+
+            const auto batches = realloc_zeroed(layer.charBatches, layer.charBatchCap, cap);
+
+            if (!batches) {
+                log_error("Failed to allocate memory for character batches!");
+                return false;
+            }
+
+            layer.charBatches = batches;
+
+            const auto shaderProps = realloc_zeroed(layer.charBatchShaderProps, layer.charBatchCap, cap);
+
+            if (!shaderProps) {
+                log_error("Failed to allocate memory for character batches!");
+                return false;
+            }
+
+            layer.charBatchShaderProps = shaderProps;
+
+            layer.charBatchCap = cap;
+        }
+
+        // The uniform buffer is always the full size of the block declared in the shader, with its contents starting out zeroed to match the properties array.
+        if (!layer.charBatchPropsUniBufGLID) {
+            static const CharBatchShaderProps lk_zeroedProps[gk_renderLayerCharBatchLimit] = {};
+
+            glGenBuffers(1, &layer.charBatchPropsUniBufGLID);
+            glBindBuffer(GL_UNIFORM_BUFFER, layer.charBatchPropsUniBufGLID);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(lk_zeroedProps), lk_zeroedProps, GL_DYNAMIC_DRAW);
+        }
+
+        const int bufSizeClass = get_char_batch_buf_size_class(slotCnt);
+
+        QuadBuf buf;
+        float* slotVerts;
+
+        if (!take_char_batch_buf(renderer, bufSizeClass, buf, slotVerts)) {
+            return false;
+        }
 
         activate_bit(layer.charBatchActivity, batchIndex);
 
         layer.charBatches[batchIndex] = {
-            .quadBuf = gen_quad_buf(slotCnt, false),
+            .quadBuf = buf,
+            .bufSizeClass = bufSizeClass,
             .slotCnt = slotCnt,
+            .slotVerts = slotVerts,
+            .text = get_char_batch_buf_text(slotVerts, bufSizeClass)
         };
 
         layer.charBatches[batchIndex].displayProps = {
@@ -320,24 +1729,47 @@ namespace zf3 {
             .blend = {1.0f, 1.0f, 1.0f, 1.0f}
         };
 
-        return {
+        id = {
             .layerIndex = layerIndex,
             .batchIndex = batchIndex
         };
+
+        return true;
     }
 
     void deactivate_char_batch(Renderer& renderer, const CharBatchID id) {
         RenderLayer& layer = renderer.layers[id.layerIndex];
+        const CharBatch& batch = layer.charBatches[id.batchIndex];
+
+        return_char_batch_buf(renderer.charBatchBufPool, batch.bufSizeClass, batch.quadBuf, batch.slotVerts);
         deactivate_bit(layer.charBatchActivity, id.batchIndex);
+
+        if (batch.slotsUsed > 0) {
+            layer.mergedCharsDirty = true;
+        }
     }
 
-    void write_to_char_batch(Renderer& renderer, const CharBatchID id, const char* const text, const FontHorAlign horAlign, const FontVerAlign verAlign) {
+    bool write_to_char_batch(Renderer& renderer, const CharBatchID id, const char* const text, const FontHorAlign horAlign, const FontVerAlign verAlign) {
         RenderLayer& layer = renderer.layers[id.layerIndex];
         CharBatch& batch = layer.charBatches[id.batchIndex];
 
         const int textLen = strlen(text);
         assert(textLen > 0 && textLen <= batch.slotCnt);
 
+        // Skip the write entirely if it would produce what is already there, as is usual for labels rewritten every tick. The hash rules out most changes cheaply, with what was last written compared in full to confirm the rest.
+        unsigned int textHash = hash_bytes(text, textLen);
+        textHash = hash_bytes(&batch.displayProps.fontIndex, sizeof(batch.displayProps.fontIndex), textHash);
+        textHash = hash_bytes(&horAlign, sizeof(horAlign), textHash);
+        textHash = hash_bytes(&verAlign, sizeof(verAlign), textHash);
+
+        if (textHash == 0) {
+            textHash = 1; // 0 is reserved for a clear batch.
+        }
+
+        if (textHash == batch.textHash && textLen == batch.slotsUsed && batch.displayProps.fontIndex == batch.textFontIndex && horAlign == batch.textHorAlign && verAlign == batch.textVerAlign && memcmp(text, batch.text, textLen) == 0) {
+            return true;
+        }
+
         const FontArrangementInfo& fontArrangementInfo = get_assets().fonts.arrangementInfos[batch.displayProps.fontIndex];
         const Pt2D fontTexSize = get_assets().fonts.texSizes[batch.displayProps.fontIndex];
 
@@ -411,16 +1843,13 @@ namespace zf3 {
 
         const int textHeight = textFirstLineMinOffs + charDrawPosPen.y + textLastLineMaxHeight;
 
-        // Clear the batch so it will have only the new characters.
-        clear_char_batch(renderer, id);
+        // Lay the vertex data out in scratch memory first, so it can be compared against what is in the buffer. Slots of spaces and newlines are left zeroed.
+        static float l_verts[ik_charBatchSlotVertsCnt * gk_charBatchSlotLimit];
 
-        // Reserve memory to temporarily hold the vertex data for the characters, so we can submit it all at once at the end.
         const int vertsLen = ik_charBatchSlotVertsCnt * textLen;
-        const auto verts = static_cast<float*>(calloc(vertsLen, sizeof(float)));
+        memset(l_verts, 0, sizeof(float) * vertsLen);
 
-        if (!verts) {
-            return;
-        }
+        float* const verts = l_verts;
 
         // Write the vertex data.
         for (int i = 0; i < textLen; i++) {
@@ -456,37 +1885,79 @@ namespace zf3 {
             slotVerts[1] = charDrawPos.y;
             slotVerts[2] = charTexCoordsTopLeft.x;
             slotVerts[3] = charTexCoordsTopLeft.y;
+            slotVerts[4] = id.batchIndex;
+
+            slotVerts[5] = charDrawPos.x + fontArrangementInfo.chars.srcRects[charIndex].width;
+            slotVerts[6] = charDrawPos.y;
+            slotVerts[7] = charTexCoordsBottomRight.x;
+            slotVerts[8] = charTexCoordsTopLeft.y;
+            slotVerts[9] = id.batchIndex;
+
+            slotVerts[10] = charDrawPos.x + fontArrangementInfo.chars.srcRects[charIndex].width;
+            slotVerts[11] = charDrawPos.y + fontArrangementInfo.chars.srcRects[charIndex].height;
+            slotVerts[12] = charTexCoordsBottomRight.x;
+            slotVerts[13] = charTexCoordsBottomRight.y;
+            slotVerts[14] = id.batchIndex;
+
+            slotVerts[15] = charDrawPos.x;
+            slotVerts[16] = charDrawPos.y + fontArrangementInfo.chars.srcRects[charIndex].height;
+            slotVerts[17] = charTexCoordsTopLeft.x;
+            slotVerts[18] = charTexCoordsBottomRight.y;
+            slotVerts[19] = id.batchIndex;
+        }
+
+        // Submit only the range of slots that differ from what is in the buffer, which for a counter is often just the last few characters.
+        int changedSlotsBegin = 0;
+
+        while (changedSlotsBegin < textLen && memcmp(verts + (changedSlotsBegin * ik_charBatchSlotVertsCnt), batch.slotVerts + (changedSlotsBegin * ik_charBatchSlotVertsCnt), ik_charBatchSlotVertsSize) == 0) {
+            ++changedSlotsBegin;
+        }
+
+        int changedSlotsEnd = textLen;
+
+        while (changedSlotsEnd > changedSlotsBegin && memcmp(verts + ((changedSlotsEnd - 1) * ik_charBatchSlotVertsCnt), batch.slotVerts + ((changedSlotsEnd - 1) * ik_charBatchSlotVertsCnt), ik_charBatchSlotVertsSize) == 0) {
+            --changedSlotsEnd;
+        }
 
-            slotVerts[4] = charDrawPos.x + fontArrangementInfo.chars.srcRects[charIndex].width;
-            slotVerts[5] = charDrawPos.y;
-            slotVerts[6] = charTexCoordsBottomRight.x;
-            slotVerts[7] = charTexCoordsTopLeft.y;
+        if (changedSlotsBegin < changedSlotsEnd) {
+            const int changedVertsOffs = ik_charBatchSlotVertsCnt * changedSlotsBegin;
+            const int changedVertsSize = ik_charBatchSlotVertsSize * (changedSlotsEnd - changedSlotsBegin);
 
-            slotVerts[8] = charDrawPos.x + fontArrangementInfo.chars.srcRects[charIndex].width;
-            slotVerts[9] = charDrawPos.y + fontArrangementInfo.chars.srcRects[charIndex].height;
-            slotVerts[10] = charTexCoordsBottomRight.x;
-            slotVerts[11] = charTexCoordsBottomRight.y;
+            // Stage the changed slots in the ring buffer and have the GPU copy them across, rather than writing to a buffer it may still be reading from.
+            RingBufRange stagedRange;
 
-            slotVerts[12] = charDrawPos.x;
-            slotVerts[13] = charDrawPos.y + fontArrangementInfo.chars.srcRects[charIndex].height;
-            slotVerts[14] = charTexCoordsTopLeft.x;
-            slotVerts[15] = charTexCoordsBottomRight.y;
+            if (!write_to_ring_buf(renderer.vertRingBuf, stagedRange, verts + changedVertsOffs, changedVertsSize, sizeof(float))) {
+                return false;
+            }
+
+            glBindBuffer(GL_COPY_READ_BUFFER, renderer.vertRingBuf.glID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, batch.quadBuf.vertBufGLID);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, stagedRange.offs, sizeof(float) * changedVertsOffs, changedVertsSize);
+
+            memcpy(batch.slotVerts + changedVertsOffs, verts + changedVertsOffs, changedVertsSize);
+        }
+
+        if (changedSlotsBegin < changedSlotsEnd || batch.slotsUsed != textLen) {
+            layer.mergedCharsDirty = true;
         }
 
-        // Submit the vertex data.
-        glBindVertexArray(batch.quadBuf.vertArrayGLID);
-        glBindBuffer(GL_ARRAY_BUFFER, batch.quadBuf.vertBufGLID);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts[0]) * vertsLen, verts);
+        batch.slotsUsed = textLen;
+        batch.textHash = textHash;
+        batch.textFontIndex = batch.displayProps.fontIndex;
+        batch.textHorAlign = horAlign;
+        batch.textVerAlign = verAlign;
+        memcpy(batch.text, text, textLen);
 
-        free(verts);
+        return true;
     }
 
-    void clear_char_batch(const Renderer& renderer, const CharBatchID id) {
-        const RenderLayer& layer = renderer.layers[id.layerIndex];
-        const CharBatch& batch = layer.charBatches[id.batchIndex];
+    void clear_char_batch(Renderer& renderer, const CharBatchID id) {
+        RenderLayer& layer = renderer.layers[id.layerIndex];
+        CharBatch& batch = layer.charBatches[id.batchIndex];
 
-        glBindVertexArray(batch.quadBuf.vertArrayGLID);
-        glBindBuffer(GL_ARRAY_BUFFER, batch.quadBuf.vertBufGLID);
-        glBufferData(GL_ARRAY_BUFFER, ik_charBatchSlotVertsSize * batch.slotCnt, nullptr, GL_DYNAMIC_DRAW);
+        // The buffer contents are left as they are, so that a later write can skip uploading the slots which come out the same.
+        batch.slotsUsed = 0;
+        batch.textHash = 0;
+        layer.mergedCharsDirty = true;
     }
 }
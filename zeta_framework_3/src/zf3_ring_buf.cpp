@@ -0,0 +1,164 @@
+#include <zf3_ring_buf.h>
+
+namespace zf3 {
+    static constexpr GLuint64 ik_fenceWaitTimeout = 1000000000; // In nanoseconds. A fence not signalled by then is taken to mean the GPU has hung or the context has been lost.
+
+    static bool wait_for_ring_buf_region(RingBuf& ring, const int regionIndex) {
+        GLsync& fence = ring.regionFences[regionIndex];
+
+        if (!fence) {
+            return true;
+        }
+
+        const GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, ik_fenceWaitTimeout);
+
+        if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) {
+            log_error("Failed to wait on a ring buffer region fence%s!", waitResult == GL_TIMEOUT_EXPIRED ? " (timed out)" : "");
+            return false;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        return true;
+    }
+
+    static void mark_ring_buf_regions_written(RingBuf& ring, const int offs, const int size) {
+        for (int i = offs / ring.regionSize; i <= (offs + size - 1) / ring.regionSize; ++i) {
+            ring.regionsWritten |= 1 << i;
+        }
+    }
+
+    bool init_ring_buf(RingBuf& ring, const int regionSize) {
+        assert(is_zero(ring));
+        assert(regionSize > 0);
+
+        ring.size = regionSize * gk_ringBufRegionCnt;
+        ring.regionSize = regionSize;
+
+        glGenBuffers(1, &ring.glID);
+        glBindBuffer(GL_ARRAY_BUFFER, ring.glID);
+
+        // Buffer storage is core only from GL 4.4, so is used through the extension where the driver supports it.
+        if (GLAD_GL_ARB_buffer_storage && glBufferStorage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, ring.size, nullptr, flags);
+            ring.persistentPtr = static_cast<Byte*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, ring.size, flags));
+
+            if (!ring.persistentPtr) {
+                log_error("Failed to persistently map a ring buffer!");
+                clean_ring_buf(ring);
+                return false;
+            }
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, ring.size, nullptr, GL_STREAM_DRAW);
+        }
+
+        return true;
+    }
+
+    void clean_ring_buf(RingBuf& ring) {
+        for (int i = 0; i < gk_ringBufRegionCnt; ++i) {
+            if (ring.regionFences[i]) {
+                glDeleteSync(ring.regionFences[i]);
+            }
+        }
+
+        if (ring.glID) {
+            if (ring.persistentPtr) {
+                glBindBuffer(GL_ARRAY_BUFFER, ring.glID);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+
+            glDeleteBuffers(1, &ring.glID);
+        }
+
+        zero_out(ring);
+    }
+
+    // Copies the data into the next free range of the ring buffer, which is given back through the range argument. The offset of the range is a multiple of the given alignment, which need not be a power of two, so that it can be used as a base vertex or instance. Returns false if a region could not be waited on, in which case nothing is written.
+    bool write_to_ring_buf(RingBuf& ring, RingBufRange& range, const void* const data, const int size, const int align) {
+        assert(size > 0 && size <= ring.regionSize);
+        assert(align > 0);
+
+        int offs = ((ring.head + align - 1) / align) * align;
+        bool wrapped = false;
+
+        if (offs + size > ring.size) {
+            offs = 0;
+            wrapped = true;
+        }
+
+        // Wait on the regions being entered, which excludes the one holding the last byte written as it was waited on when entered. If a region is entered again within a frame its data may not have been read yet, so it is fenced early and waited on, which stalls but keeps the data intact.
+        const int headRegionIndex = !wrapped && ring.head > 0 ? (ring.head - 1) / ring.regionSize : -1;
+        const int firstRegionIndex = offs / ring.regionSize;
+        const int lastRegionIndex = (offs + size - 1) / ring.regionSize;
+
+        for (int i = firstRegionIndex; i <= lastRegionIndex; ++i) {
+            if (i == headRegionIndex) {
+                continue;
+            }
+
+            if (ring.regionsWritten & (1 << i)) {
+                fence_ring_buf(ring);
+            }
+
+            if (!wait_for_ring_buf_region(ring, i)) {
+                return false;
+            }
+        }
+
+        mark_ring_buf_regions_written(ring, offs, size);
+
+        if (ring.persistentPtr) {
+            memcpy(ring.persistentPtr + offs, data, size);
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, ring.glID);
+            glBufferSubData(GL_ARRAY_BUFFER, offs, size, data);
+        }
+
+        if (wrapped) {
+            ++ring.lap;
+        }
+
+        ring.head = offs + size;
+
+        range = {
+            .offs = offs,
+            .size = size,
+            .lap = ring.lap
+        };
+
+        return true;
+    }
+
+    // Returns whether the range still holds what was written to it, in which case it is fenced again along with this frame's writes so that it can be drawn from. Only ranges written since writing last wrapped around qualify, as those are all behind the head and so cannot be written over before the regions are next waited on.
+    bool reuse_ring_buf_range(RingBuf& ring, const RingBufRange& range) {
+        if (range.size == 0 || range.lap != ring.lap) {
+            return false;
+        }
+
+        assert(range.offs + range.size <= ring.head);
+
+        mark_ring_buf_regions_written(ring, range.offs, range.size);
+
+        return true;
+    }
+
+    // Places fences on the regions written since the last call, to be waited on before they are written again. Should be called once the draws reading from them have been issued.
+    void fence_ring_buf(RingBuf& ring) {
+        for (int i = 0; i < gk_ringBufRegionCnt; ++i) {
+            if (!(ring.regionsWritten & (1 << i))) {
+                continue;
+            }
+
+            if (ring.regionFences[i]) {
+                glDeleteSync(ring.regionFences[i]);
+            }
+
+            ring.regionFences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        ring.regionsWritten = 0;
+    }
+}
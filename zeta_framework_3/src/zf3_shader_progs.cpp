@@ -1,11 +1,28 @@
 #include <zf3_shader_progs.h>
 
+#include <filesystem>
+
 namespace zf3 {
-    static GLID create_shader_from_src(const char* const src, const bool frag) {
+    // Returns whether the driver will compile and link in the background, in which case status queries made before then would block and are to be left until completion.
+    static bool enable_parallel_shader_compile() {
+        if (!GLAD_GL_KHR_parallel_shader_compile || !glMaxShaderCompilerThreadsKHR) {
+            return false;
+        }
+
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // Lets the driver use as many threads as it sees fit.
+
+        return true;
+    }
+
+    // Starts compiling the shader without waiting on the result, which is checked when the program is completed.
+    static GLID submit_shader(const char* const src, const bool frag) {
         const GLID glID = glCreateShader(frag ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER);
         glShaderSource(glID, 1, &src, nullptr);
         glCompileShader(glID);
+        return glID;
+    }
 
+    static bool check_shader_compiled(const GLID glID) {
         GLint compileSuccess;
         glGetShaderiv(glID, GL_COMPILE_STATUS, &compileSuccess);
 
@@ -14,41 +31,404 @@ namespace zf3 {
             glGetShaderInfoLog(glID, sizeof(infoLog), nullptr, infoLog);
             log_error("Failed to compile shader!\n\n%s\n", infoLog);
 
-            glDeleteShader(glID);
+            return false;
+        }
 
-            return 0;
+        return true;
+    }
+
+    static constexpr const char* ik_progBinaryCacheDirName = "shader_cache";
+    static constexpr const char* ik_progBinaryCacheFilePathFormat = "%s/%016llx.bin";
+    static constexpr int ik_progBinaryCacheFilePathBufSize = 64;
+
+    static constexpr int ik_progBinaryCacheMagic = 'Z' | ('F' << 8) | ('3' << 16) | ('S' << 24);
+    static constexpr int ik_progBinaryCacheVersion = 2; // Must be incremented whenever the layout of a cache file changes, so that stale files are rejected.
+    static constexpr int ik_progBinaryCacheDriverStrBufSize = 128;
+
+    // Precedes the program binary in a cache file. Binaries are only valid for the driver and sources that produced them. The driver strings are recorded in full, and the sources by their lengths and a second hash independent of the key, so that a key collision is caught rather than loading the wrong program.
+    struct ProgBinaryCacheHeader {
+        int magic;
+        int version;
+        unsigned long long key;
+        char glRenderer[ik_progBinaryCacheDriverStrBufSize]; // Truncated and zero-padded.
+        char glVersion[ik_progBinaryCacheDriverStrBufSize]; // Truncated and zero-padded.
+        int vertShaderSrcLen;
+        int fragShaderSrcLen;
+        unsigned int srcHash;
+
+        GLenum format;
+        int binarySize;
+    };
+
+    static void copy_gl_str_to_buf(char (&buf)[ik_progBinaryCacheDriverStrBufSize], const GLenum name) {
+        const char* const str = reinterpret_cast<const char*>(glGetString(name));
+
+        if (str) {
+            strncpy(buf, str, sizeof(buf) - 1);
         }
+    }
 
-        return glID;
+    // Binaries are only valid for the driver that produced them, so the driver strings are hashed along with the sources.
+    static unsigned long long get_prog_binary_cache_key(const char* const vertShaderSrc, const char* const fragShaderSrc) {
+        unsigned long long key = 14695981039346656037ull;
+
+        const GLenum driverStrNames[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+
+        for (const GLenum name : driverStrNames) {
+            const char* const str = reinterpret_cast<const char*>(glGetString(name));
+
+            if (str) {
+                key = hash_bytes_64(str, strlen(str), key);
+            }
+        }
+
+        key = hash_bytes_64(vertShaderSrc, strlen(vertShaderSrc), key);
+        key = hash_bytes_64(fragShaderSrc, strlen(fragShaderSrc), key);
+
+        return key;
+    }
+
+    // Hashes the sources alone with the 32-bit hash, so that a collision would have to occur in both this and the key for a cache file to be mistaken for another.
+    static unsigned int get_prog_binary_cache_src_hash(const char* const vertShaderSrc, const char* const fragShaderSrc) {
+        const unsigned int hash = hash_bytes(vertShaderSrc, strlen(vertShaderSrc));
+        return hash_bytes(fragShaderSrc, strlen(fragShaderSrc), hash);
     }
 
-    static GLID create_shader_prog_from_srcs(const char* const vertShaderSrc, const char* const fragShaderSrc) {
-        const GLID vertShaderGLID = create_shader_from_src(vertShaderSrc, false);
+    // Fills in everything a cache file for the program must match, leaving the binary format and size.
+    static ProgBinaryCacheHeader make_prog_binary_cache_header(const PendingShaderProg& prog) {
+        ProgBinaryCacheHeader header = {};
+        header.magic = ik_progBinaryCacheMagic;
+        header.version = ik_progBinaryCacheVersion;
+        header.key = prog.binaryCacheKey;
+        copy_gl_str_to_buf(header.glRenderer, GL_RENDERER);
+        copy_gl_str_to_buf(header.glVersion, GL_VERSION);
+        header.vertShaderSrcLen = prog.vertShaderSrcLen;
+        header.fragShaderSrcLen = prog.fragShaderSrcLen;
+        header.srcHash = prog.srcHash;
+        return header;
+    }
+
+    static bool does_prog_binary_cache_header_match(const ProgBinaryCacheHeader& header, const ProgBinaryCacheHeader& expected) {
+        return header.magic == expected.magic
+            && header.version == expected.version
+            && header.key == expected.key
+            && memcmp(header.glRenderer, expected.glRenderer, sizeof(header.glRenderer)) == 0
+            && memcmp(header.glVersion, expected.glVersion, sizeof(header.glVersion)) == 0
+            && header.vertShaderSrcLen == expected.vertShaderSrcLen
+            && header.fragShaderSrcLen == expected.fragShaderSrcLen
+            && header.srcHash == expected.srcHash
+            && header.binarySize > 0;
+    }
+
+    static void get_prog_binary_cache_file_path(char (&buf)[ik_progBinaryCacheFilePathBufSize], const unsigned long long key) {
+        const int len = snprintf(buf, sizeof(buf), ik_progBinaryCacheFilePathFormat, ik_progBinaryCacheDirName, key);
+        assert(len < ik_progBinaryCacheFilePathBufSize);
+    }
+
+    // Returns 0 if there is no usable cached binary for the program. A cache file that does not match or that the driver rejects is deleted.
+    static GLID load_prog_from_binary_cache(const PendingShaderProg& prog) {
+        char filePath[ik_progBinaryCacheFilePathBufSize];
+        get_prog_binary_cache_file_path(filePath, prog.binaryCacheKey);
+
+        FILE* const fs = fopen(filePath, "rb");
+
+        if (!fs) {
+            return 0;
+        }
+
+        const ProgBinaryCacheHeader expectedHeader = make_prog_binary_cache_header(prog);
+
+        ProgBinaryCacheHeader header;
+
+        if (fread(&header, sizeof(header), 1, fs) != 1 || !does_prog_binary_cache_header_match(header, expectedHeader)) {
+            fclose(fs);
+
+            log("Cached shader program binary \"%s\" is stale or corrupt, deleting it.", filePath);
+            remove(filePath);
 
-        if (!vertShaderGLID) {
             return 0;
         }
 
-        const GLID fragShaderGLID = create_shader_from_src(fragShaderSrc, true);
+        const auto binary = alloc<Byte>(header.binarySize);
 
-        if (!fragShaderGLID) {
-            glDeleteShader(vertShaderGLID);
+        if (!binary) {
+            fclose(fs);
             return 0;
         }
 
-        const GLID progGLID = glCreateProgram();
-        glAttachShader(progGLID, vertShaderGLID);
-        glAttachShader(progGLID, fragShaderGLID);
-        glLinkProgram(progGLID);
+        const bool binaryRead = fread(binary, 1, header.binarySize, fs) == static_cast<size_t>(header.binarySize);
 
-        // We no longer need the shaders, as they are now part of the program.
-        glDeleteShader(vertShaderGLID);
-        glDeleteShader(fragShaderGLID);
+        fclose(fs);
+
+        GLID progGLID = 0;
+
+        if (binaryRead) {
+            progGLID = glCreateProgram();
+            glProgramBinary(progGLID, header.format, binary, header.binarySize);
+
+            GLint linkSuccess;
+            glGetProgramiv(progGLID, GL_LINK_STATUS, &linkSuccess);
+
+            // The driver may have been updated in a way its strings do not show.
+            if (!linkSuccess) {
+                glDeleteProgram(progGLID);
+                progGLID = 0;
+            }
+        }
+
+        free(binary);
+
+        if (!progGLID) {
+            log("Cached shader program binary \"%s\" was truncated or rejected, deleting it and compiling from source instead.", filePath);
+            remove(filePath);
+        }
 
         return progGLID;
     }
 
-    static SpriteQuadShaderProg load_sprite_quad_shader_prog() {
+    static void write_prog_to_binary_cache(const GLID progGLID, const PendingShaderProg& prog) {
+        GLint binarySize = 0;
+        glGetProgramiv(progGLID, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+
+        // Programs which failed to link have no binary.
+        if (binarySize <= 0) {
+            return;
+        }
+
+        const auto binary = alloc<Byte>(binarySize);
+
+        if (!binary) {
+            return;
+        }
+
+        ProgBinaryCacheHeader header = make_prog_binary_cache_header(prog);
+        glGetProgramBinary(progGLID, binarySize, &header.binarySize, &header.format, binary);
+
+        std::error_code errCode;
+        std::filesystem::create_directories(ik_progBinaryCacheDirName, errCode);
+
+        if (errCode) {
+            log_error("Failed to create the shader program binary cache directory \"%s\"!", ik_progBinaryCacheDirName);
+            free(binary);
+            return;
+        }
+
+        char filePath[ik_progBinaryCacheFilePathBufSize];
+        get_prog_binary_cache_file_path(filePath, prog.binaryCacheKey);
+
+        FILE* const fs = fopen(filePath, "wb");
+
+        if (fs) {
+            const bool written = fwrite(&header, sizeof(header), 1, fs) == 1 && fwrite(binary, 1, header.binarySize, fs) == static_cast<size_t>(header.binarySize);
+
+            // Closing flushes, so can fail too.
+            if (fclose(fs) != 0 || !written) {
+                log_error("Failed to write shader program binary cache file \"%s\"!", filePath);
+                remove(filePath);
+            }
+        } else {
+            log_error("Failed to open \"%s\" to cache a shader program binary!", filePath);
+        }
+
+        free(binary);
+    }
+
+    static constexpr int ik_shaderSrcLenLimit = 4096;
+
+    // Copies the source with the defines inserted after the version directive, which must come first. Defines for the constants shared with the renderer go in ahead of the given ones, so that array lengths and binding points in the shaders always match.
+    static void assemble_shader_src(char (&buf)[ik_shaderSrcLenLimit], const char* const src, const char* const defines) {
+        const char* const versionEnd = strchr(src, '\n') + 1;
+
+        const int len = snprintf(buf, sizeof(buf),
+            "%.*s"
+            "#define TEX_UNIT_LIMIT %d\n"
+            "#define VIEW_CNT %d\n"
+            "#define CHAR_BATCH_LIMIT %d\n"
+            "#define CHAR_BATCH_PROPS_BINDING %d\n"
+            "%s%s",
+            static_cast<int>(versionEnd - src), src,
+            gk_texUnitLimit,
+            gk_shaderProgViewCnt,
+            gk_charQuadShaderProgBatchLimit,
+            gk_charQuadShaderProgBatchPropsBinding,
+            defines, versionEnd);
+
+        assert(len < ik_shaderSrcLenLimit);
+    }
+
+    // Loads the program from the binary cache if possible, otherwise submitting its shaders for compiling and the program for linking. The defines specialise both shaders.
+    static PendingShaderProg submit_shader_prog(const char* const name, const char* const vertShaderSrcBase, const char* const fragShaderSrcBase, const char* const defines, const bool useBinaryCache) {
+        const double submitStartTime = glfwGetTime();
+
+        char vertShaderSrc[ik_shaderSrcLenLimit];
+        assemble_shader_src(vertShaderSrc, vertShaderSrcBase, defines);
+
+        char fragShaderSrc[ik_shaderSrcLenLimit];
+        assemble_shader_src(fragShaderSrc, fragShaderSrcBase, defines);
+
+        PendingShaderProg prog = {};
+        prog.name = name;
+
+        if (useBinaryCache) {
+            prog.binaryCacheKey = get_prog_binary_cache_key(vertShaderSrc, fragShaderSrc);
+            prog.vertShaderSrcLen = strlen(vertShaderSrc);
+            prog.fragShaderSrcLen = strlen(fragShaderSrc);
+            prog.srcHash = get_prog_binary_cache_src_hash(vertShaderSrc, fragShaderSrc);
+            prog.glID = load_prog_from_binary_cache(prog);
+
+            if (prog.glID) {
+                prog.fromBinaryCache = true;
+                prog.submitDur = glfwGetTime() - submitStartTime;
+                return prog;
+            }
+        }
+
+        prog.vertShaderGLID = submit_shader(vertShaderSrc, false);
+        prog.fragShaderGLID = submit_shader(fragShaderSrc, true);
+
+        prog.glID = glCreateProgram();
+        glAttachShader(prog.glID, prog.vertShaderGLID);
+        glAttachShader(prog.glID, prog.fragShaderGLID);
+
+        if (useBinaryCache) {
+            glProgramParameteri(prog.glID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        glLinkProgram(prog.glID);
+
+        prog.submitDur = glfwGetTime() - submitStartTime;
+
+        return prog;
+    }
+
+    // Waits for the program to finish linking if it has not already, returning its GL ID or 0 if compiling or linking failed. The shaders are deleted either way.
+    static GLID complete_shader_prog(PendingShaderProg& prog, const bool parallel, const bool useBinaryCache) {
+        const double waitStartTime = glfwGetTime();
+
+        GLID glID = prog.glID;
+
+        if (!prog.fromBinaryCache) {
+            GLint linkDone = true;
+
+            if (parallel) {
+                glGetProgramiv(glID, GL_COMPLETION_STATUS_KHR, &linkDone);
+            }
+
+            GLint linkSuccess;
+            glGetProgramiv(glID, GL_LINK_STATUS, &linkSuccess);
+
+            if (linkSuccess) {
+                if (useBinaryCache) {
+                    write_prog_to_binary_cache(glID, prog);
+                }
+            } else {
+                // A shader failing to compile also fails the link, in which case the shader log is the useful one.
+                if (check_shader_compiled(prog.vertShaderGLID) && check_shader_compiled(prog.fragShaderGLID)) {
+                    GLchar infoLog[512];
+                    glGetProgramInfoLog(glID, sizeof(infoLog), nullptr, infoLog);
+                    log_error("Failed to link shader program \"%s\"!\n\n%s\n", prog.name, infoLog);
+                }
+
+                glDeleteProgram(glID);
+                glID = 0;
+            }
+
+            // We no longer need the shaders, as they are now part of the program.
+            glDeleteShader(prog.vertShaderGLID);
+            glDeleteShader(prog.fragShaderGLID);
+
+            if (glID) {
+                const double waitDur = glfwGetTime() - waitStartTime;
+                log("Compiled and linked shader program \"%s\" (%.2f ms to submit, %.2f ms waited on at completion%s).", prog.name, prog.submitDur * 1000.0, waitDur * 1000.0, linkDone ? "" : ", still in progress when completion began");
+            }
+        } else {
+            log("Loaded shader program \"%s\" from the binary cache (%.2f ms).", prog.name, prog.submitDur * 1000.0);
+        }
+
+        zero_out(prog);
+
+        return glID;
+    }
+
+    // Deletes whatever of the program has been created, for when it is not going to be completed.
+    static void abandon_shader_prog(PendingShaderProg& prog) {
+        if (prog.glID) {
+            glDeleteProgram(prog.glID);
+        }
+
+        if (prog.vertShaderGLID) {
+            glDeleteShader(prog.vertShaderGLID);
+        }
+
+        if (prog.fragShaderGLID) {
+            glDeleteShader(prog.fragShaderGLID);
+        }
+
+        zero_out(prog);
+    }
+
+    // Submits each variant of the sprite program, specialised by the defines matching its flags.
+    static void submit_sprite_quad_shader_prog_variants(PendingShaderProg (&progs)[gk_spriteQuadShaderProgVariantCnt], const char* const (&names)[gk_spriteQuadShaderProgVariantCnt], const char* const vertShaderSrc, const bool texArrays, const bool useBinaryCache) {
+        const char* const fragShaderSrc =
+            "#version 430 core\n"
+            "\n"
+            "in flat int v_texIndex;\n"
+            "in vec2 v_texCoord;\n"
+            "in float v_alpha;\n"
+            "\n"
+            "out vec4 o_fragColor;\n"
+            "\n"
+            "uniform sampler2D u_textures[TEX_UNIT_LIMIT];\n"
+            "\n"
+            "void main()\n"
+            "{\n"
+            "    vec4 texColor = texture(u_textures[v_texIndex], v_texCoord);\n"
+            "\n"
+            "#ifdef OPAQUE\n"
+            "    o_fragColor = texColor;\n"
+            "#else\n"
+            "    o_fragColor = texColor * vec4(1.0f, 1.0f, 1.0f, v_alpha);\n"
+            "#endif\n"
+            "}\n";
+
+        // When textures are loaded into arrays, each batch samples up to a full set of arrays and the texture index holds both the unit and the layer.
+        const char* const texArrayFragShaderSrc =
+            "#version 430 core\n"
+            "\n"
+            "in flat int v_texIndex;\n"
+            "in vec2 v_texCoord;\n"
+            "in float v_alpha;\n"
+            "\n"
+            "out vec4 o_fragColor;\n"
+            "\n"
+            "uniform sampler2DArray u_textures[TEX_UNIT_LIMIT];\n"
+            "\n"
+            "void main()\n"
+            "{\n"
+            "    vec4 texColor = texture(u_textures[v_texIndex % TEX_UNIT_LIMIT], vec3(v_texCoord, v_texIndex / TEX_UNIT_LIMIT));\n"
+            "\n"
+            "#ifdef OPAQUE\n"
+            "    o_fragColor = texColor;\n"
+            "#else\n"
+            "    o_fragColor = texColor * vec4(1.0f, 1.0f, 1.0f, v_alpha);\n"
+            "#endif\n"
+            "}\n";
+
+        static const char* const lk_variantDefines[gk_spriteQuadShaderProgVariantCnt] = {
+            "",
+            "#define NO_ROT\n",
+            "#define OPAQUE\n",
+            "#define NO_ROT\n#define OPAQUE\n"
+        };
+
+        static_assert(gk_spriteQuadShaderProgNoRotFlag == 1 && gk_spriteQuadShaderProgOpaqueFlag == 2, "The variant defines are indexed by flags.");
+
+        for (int i = 0; i < gk_spriteQuadShaderProgVariantCnt; ++i) {
+            progs[i] = submit_shader_prog(names[i], vertShaderSrc, texArrays ? texArrayFragShaderSrc : fragShaderSrc, lk_variantDefines[i], useBinaryCache);
+        }
+    }
+
+    static void submit_sprite_quad_shader_progs(PendingShaderProg (&progs)[gk_spriteQuadShaderProgVariantCnt], const bool texArrays, const bool useBinaryCache) {
         const char* const vertShaderSrc =
             "#version 430 core\n"
             "layout (location = 0) in vec2 a_vert;\n"
@@ -63,11 +443,18 @@ namespace zf3 {
             "out vec2 v_texCoord;\n"
             "out float v_alpha;\n"
             "\n"
-            "uniform mat4 u_view;\n"
-            "uniform mat4 u_proj;\n"
+            "layout (std140) uniform MatricesBlock {\n"
+            "    mat4 u_proj;\n"
+            "    mat4 u_views[VIEW_CNT];\n"
+            "};\n"
+            "\n"
+            "uniform int u_viewIndex;\n"
             "\n"
             "void main()\n"
             "{\n"
+            "#ifdef NO_ROT\n"
+            "    gl_Position = u_proj * u_views[u_viewIndex] * vec4(a_pos + (a_vert * a_size), 0.0f, 1.0f);\n"
+            "#else\n"
             "    float rotCos = cos(a_rot);\n"
             "    float rotSin = -sin(a_rot);\n"
             "\n"
@@ -78,116 +465,237 @@ namespace zf3 {
             "        vec4(a_pos.x, a_pos.y, 0.0f, 1.0f)\n"
             "    );\n"
             "\n"
-            "    gl_Position = u_proj * u_view * model * vec4(a_vert, 0.0f, 1.0f);\n"
+            "    gl_Position = u_proj * u_views[u_viewIndex] * model * vec4(a_vert, 0.0f, 1.0f);\n"
+            "#endif\n"
             "\n"
             "    v_texIndex = int(a_texIndex);\n"
             "    v_texCoord = a_texCoord;\n"
             "    v_alpha = a_alpha;\n"
             "}\n";
 
-        const char* const fragShaderSrc =
+        static const char* const lk_names[gk_spriteQuadShaderProgVariantCnt] = {"sprite quad", "sprite quad, no rotation", "sprite quad, opaque", "sprite quad, no rotation, opaque"};
+        submit_sprite_quad_shader_prog_variants(progs, lk_names, vertShaderSrc, texArrays, useBinaryCache);
+    }
+
+    static void submit_sprite_quad_inst_shader_progs(PendingShaderProg (&progs)[gk_spriteQuadShaderProgVariantCnt], const bool texArrays, const bool useBinaryCache) {
+        // Each instance is a single sprite; the unit quad vertex is expanded into its corner here, which avoids duplicating the sprite properties across four vertices.
+        const char* const vertShaderSrc =
             "#version 430 core\n"
+            "layout (location = 0) in vec2 a_vert;\n"
+            "layout (location = 1) in vec2 a_pos;\n"
+            "layout (location = 2) in vec2 a_size;\n"
+            "layout (location = 3) in vec2 a_origin;\n"
+            "layout (location = 4) in float a_rot;\n"
+            "layout (location = 5) in float a_alpha;\n"
+            "layout (location = 6) in vec4 a_texCoords;\n"
+            "layout (location = 7) in int a_texIndex;\n"
             "\n"
-            "in flat int v_texIndex;\n"
-            "in vec2 v_texCoord;\n"
-            "in float v_alpha;\n"
+            "out flat int v_texIndex;\n"
+            "out vec2 v_texCoord;\n"
+            "out float v_alpha;\n"
             "\n"
-            "out vec4 o_fragColor;\n"
+            "layout (std140) uniform MatricesBlock {\n"
+            "    mat4 u_proj;\n"
+            "    mat4 u_views[VIEW_CNT];\n"
+            "};\n"
             "\n"
-            "uniform sampler2D u_textures[32];\n"
+            "uniform int u_viewIndex;\n"
             "\n"
             "void main()\n"
             "{\n"
-            "    vec4 texColor = texture(u_textures[v_texIndex], v_texCoord);\n"
-            "    o_fragColor = texColor * vec4(1.0f, 1.0f, 1.0f, v_alpha);\n"
+            "    vec2 offs = (a_vert - a_origin) * a_size;\n"
+            "\n"
+            "#ifdef NO_ROT\n"
+            "    vec2 pos = a_pos + offs;\n"
+            "#else\n"
+            "    float rotCos = cos(a_rot);\n"
+            "    float rotSin = sin(a_rot);\n"
+            "\n"
+            "    vec2 pos = a_pos + vec2((offs.x * rotCos) + (offs.y * rotSin), (offs.y * rotCos) - (offs.x * rotSin));\n"
+            "#endif\n"
+            "\n"
+            "    gl_Position = u_proj * u_views[u_viewIndex] * vec4(pos, 0.0f, 1.0f);\n"
+            "\n"
+            "    v_texIndex = a_texIndex;\n"
+            "    v_texCoord = mix(a_texCoords.xy, a_texCoords.zw, a_vert);\n"
+            "    v_alpha = a_alpha;\n"
             "}\n";
 
-        const GLID glID = create_shader_prog_from_srcs(vertShaderSrc, fragShaderSrc);
-        assert(glID);
-
-        return {
-            .glID = glID,
-            .projUniLoc = glGetUniformLocation(glID, "u_proj"),
-            .viewUniLoc = glGetUniformLocation(glID, "u_view"),
-            .texturesUniLoc = glGetUniformLocation(glID, "u_textures")
-        };
+        static const char* const lk_names[gk_spriteQuadShaderProgVariantCnt] = {"instanced sprite quad", "instanced sprite quad, no rotation", "instanced sprite quad, opaque", "instanced sprite quad, no rotation, opaque"};
+        submit_sprite_quad_shader_prog_variants(progs, lk_names, vertShaderSrc, texArrays, useBinaryCache);
     }
 
-    static CharQuadShaderProg load_char_quad_shader_prog() {
+    static PendingShaderProg submit_char_quad_shader_prog(const bool useBinaryCache) {
+        // The display properties of each batch are read from a uniform buffer by the batch index of the vertex, which lets batches sharing a font be drawn together.
         const char* const vertShaderSrc =
             "#version 430 core\n"
             "\n"
             "layout (location = 0) in vec2 a_vert;\n"
             "layout (location = 1) in vec2 a_texCoord;\n"
+            "layout (location = 2) in float a_batchIndex;\n"
             "\n"
             "out vec2 v_texCoord;\n"
+            "out vec4 v_blend;\n"
+            "\n"
+            "struct BatchProps {\n"
+            "    vec2 pos;\n"
+            "    float rot;\n"
+            "    vec4 blend;\n"
+            "};\n"
+            "\n"
+            "layout (std140, binding = CHAR_BATCH_PROPS_BINDING) uniform BatchPropsBlock {\n"
+            "    BatchProps u_batchProps[CHAR_BATCH_LIMIT];\n"
+            "};\n"
             "\n"
-            "uniform vec2 u_pos;\n"
-            "uniform float u_rot;\n"
+            "layout (std140) uniform MatricesBlock {\n"
+            "    mat4 u_proj;\n"
+            "    mat4 u_views[VIEW_CNT];\n"
+            "};\n"
             "\n"
-            "uniform mat4 u_proj;\n"
-            "uniform mat4 u_view;\n"
+            "uniform int u_viewIndex;\n"
             "\n"
             "void main()\n"
             "{\n"
-            "    float rotCos = cos(u_rot);\n"
-            "    float rotSin = sin(u_rot);\n"
+            "    BatchProps props = u_batchProps[int(a_batchIndex)];\n"
+            "\n"
+            "    float rotCos = cos(props.rot);\n"
+            "    float rotSin = sin(props.rot);\n"
             "\n"
             "    mat4 model = mat4(\n"
             "        vec4(rotCos, rotSin, 0.0f, 0.0f),\n"
             "        vec4(-rotSin, rotCos, 0.0f, 0.0f),\n"
             "        vec4(0.0f, 0.0f, 1.0f, 0.0f),\n"
-            "        vec4(u_pos.x, u_pos.y, 0.0f, 1.0f)\n"
+            "        vec4(props.pos.x, props.pos.y, 0.0f, 1.0f)\n"
             "    );\n"
             "\n"
-            "    gl_Position = u_proj * u_view * model * vec4(a_vert, 0.0f, 1.0f);\n"
+            "    gl_Position = u_proj * u_views[u_viewIndex] * model * vec4(a_vert, 0.0f, 1.0f);\n"
             "\n"
             "    v_texCoord = a_texCoord;\n"
+            "    v_blend = props.blend;\n"
             "}\n";
 
         const char* const fragShaderSrc =
             "#version 430 core\n"
             "\n"
             "in vec2 v_texCoord;\n"
+            "in vec4 v_blend;\n"
             "\n"
             "out vec4 o_fragColor;\n"
             "\n"
-            "uniform vec4 u_blend;\n"
             "uniform sampler2D u_tex;\n"
             "\n"
             "void main()\n"
             "{\n"
             "    vec4 texColor = texture(u_tex, v_texCoord);\n"
-            "    o_fragColor = texColor * u_blend;\n"
+            "    o_fragColor = texColor * v_blend;\n"
             "}\n";
 
-        const GLID glID = create_shader_prog_from_srcs(vertShaderSrc, fragShaderSrc);
-        assert(glID);
+        return submit_shader_prog("character quad", vertShaderSrc, fragShaderSrc, "", useBinaryCache);
+    }
+
+    static void bind_matrices_uni_block(const GLID progGLID) {
+        const GLuint blockIndex = glGetUniformBlockIndex(progGLID, "MatricesBlock");
+        assert(blockIndex != GL_INVALID_INDEX);
+
+        glUniformBlockBinding(progGLID, blockIndex, gk_shaderProgMatricesBinding);
+    }
+
+    static SpriteQuadShaderProg complete_sprite_quad_shader_prog(PendingShaderProg& pendingProg, const bool parallel, const bool useBinaryCache) {
+        const GLID glID = complete_shader_prog(pendingProg, parallel, useBinaryCache);
+
+        if (!glID) {
+            return {};
+        }
+
+        bind_matrices_uni_block(glID);
 
         return {
             .glID = glID,
-            .projUniLoc = glGetUniformLocation(glID, "u_proj"),
-            .viewUniLoc = glGetUniformLocation(glID, "u_view"),
-            .posUniLoc = glGetUniformLocation(glID, "u_pos"),
-            .rotUniLoc = glGetUniformLocation(glID, "u_rot"),
-            .blendUniLoc = glGetUniformLocation(glID, "u_blend")
+            .viewIndexUniLoc = glGetUniformLocation(glID, "u_viewIndex"),
+            .texturesUniLoc = glGetUniformLocation(glID, "u_textures")
         };
     }
 
-    ShaderProgs load_shader_progs() {
+    static CharQuadShaderProg complete_char_quad_shader_prog(PendingShaderProg& pendingProg, const bool parallel, const bool useBinaryCache) {
+        const GLID glID = complete_shader_prog(pendingProg, parallel, useBinaryCache);
+
+        if (!glID) {
+            return {};
+        }
+
+        bind_matrices_uni_block(glID);
+
         return {
-            .spriteQuad = load_sprite_quad_shader_prog(),
-            .charQuad = load_char_quad_shader_prog()
+            .glID = glID,
+            .viewIndexUniLoc = glGetUniformLocation(glID, "u_viewIndex")
         };
     }
 
+    PendingShaderProgs submit_shader_progs(const bool texArrays) {
+        PendingShaderProgs progs = {};
+
+        progs.parallel = enable_parallel_shader_compile();
+
+        GLint binaryFormatCnt = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCnt);
+        progs.useBinaryCache = binaryFormatCnt > 0;
+
+        submit_sprite_quad_shader_progs(progs.spriteQuad, texArrays, progs.useBinaryCache);
+        submit_sprite_quad_inst_shader_progs(progs.spriteQuadInst, texArrays, progs.useBinaryCache);
+        progs.charQuad = submit_char_quad_shader_prog(progs.useBinaryCache);
+
+        return progs;
+    }
+
+    bool complete_shader_progs(ShaderProgs& progs, PendingShaderProgs& pendingProgs) {
+        assert(is_zero(progs));
+
+        bool success = true;
+
+        for (int i = 0; i < gk_spriteQuadShaderProgVariantCnt; ++i) {
+            progs.spriteQuad[i] = complete_sprite_quad_shader_prog(pendingProgs.spriteQuad[i], pendingProgs.parallel, pendingProgs.useBinaryCache);
+            progs.spriteQuadInst[i] = complete_sprite_quad_shader_prog(pendingProgs.spriteQuadInst[i], pendingProgs.parallel, pendingProgs.useBinaryCache);
+            success &= progs.spriteQuad[i].glID && progs.spriteQuadInst[i].glID;
+        }
+
+        progs.charQuad = complete_char_quad_shader_prog(pendingProgs.charQuad, pendingProgs.parallel, pendingProgs.useBinaryCache);
+        success &= progs.charQuad.glID != 0;
+
+        zero_out(pendingProgs);
+
+        if (!success) {
+            unload_shader_progs(progs);
+            return false;
+        }
+
+        return true;
+    }
+
+    // For when loading fails between submitting and completing the programs.
+    void abandon_shader_progs(PendingShaderProgs& pendingProgs) {
+        for (int i = 0; i < gk_spriteQuadShaderProgVariantCnt; ++i) {
+            abandon_shader_prog(pendingProgs.spriteQuad[i]);
+            abandon_shader_prog(pendingProgs.spriteQuadInst[i]);
+        }
+
+        abandon_shader_prog(pendingProgs.charQuad);
+
+        zero_out(pendingProgs);
+    }
+
     void unload_shader_progs(ShaderProgs& progs) {
-        if (progs.spriteQuad.glID) {
-            glDeleteProgram(progs.charQuad.glID);
+        for (int i = 0; i < gk_spriteQuadShaderProgVariantCnt; ++i) {
+            if (progs.spriteQuad[i].glID) {
+                glDeleteProgram(progs.spriteQuad[i].glID);
+            }
+
+            if (progs.spriteQuadInst[i].glID) {
+                glDeleteProgram(progs.spriteQuadInst[i].glID);
+            }
         }
 
         if (progs.charQuad.glID) {
-            glDeleteProgram(progs.spriteQuad.glID);
+            glDeleteProgram(progs.charQuad.glID);
         }
 
         zero_out(progs);
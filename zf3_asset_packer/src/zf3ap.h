@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -11,9 +12,16 @@
 constexpr int gk_errorMsgBufSize = 512;
 constexpr int gk_srcAssetFilePathBufSize = 256;
 
+// The table of contents of the assets file, filled in as each asset is written.
+struct AssetsFileTOC {
+    zf3::AssetsFileTOCEntry entries[zf3::gk_assetsFileTOCEntryLimit];
+    int entryCnt;
+};
+
 cJSON* get_cj_assets_array(const cJSON* const instrsCJObj, const char* const arrayName);
 bool complete_asset_file_path(char* const srcAssetFilePathBuf, char* const errorMsgBuf, const int srcAssetFilePathStartLen, const char* const relPath);
+bool add_assets_file_toc_entry(AssetsFileTOC& toc, FILE* const outputFS, char* const errorMsgBuf, const zf3::AssetType type, const long assetBeginPos, const int flags = 0);
 
-bool pack_textures(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
-bool pack_fonts(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
-bool pack_audio(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
+bool pack_textures(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
+bool pack_fonts(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
+bool pack_audio(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf);
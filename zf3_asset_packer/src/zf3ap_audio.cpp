@@ -2,7 +2,7 @@
 
 #include <sndfile.h>
 
-static bool load_and_write_audio_data_from_file(FILE* const outputFS, zf3::AudioSample* const samples, char* const errMsgBuf, const char* const filePath) {
+static bool load_and_write_audio_data_from_file(FILE* const outputFS, AssetsFileTOC& toc, zf3::AudioSample* const samples, char* const errMsgBuf, const zf3::AssetType type, const char* const filePath) {
     // Open the audio file.
     SF_INFO sfInfo;
     SNDFILE* sf = sf_open(filePath, SFM_READ, &sfInfo);
@@ -26,6 +26,8 @@ static bool load_and_write_audio_data_from_file(FILE* const outputFS, zf3::Audio
     }
 
     // Write the information.
+    const long audioBeginPos = ftell(outputFS);
+
     fwrite(&info, sizeof(info), 1, outputFS);
 
     // Read sample chunks into buffer and write them.
@@ -41,10 +43,10 @@ static bool load_and_write_audio_data_from_file(FILE* const outputFS, zf3::Audio
 
     sf_close(sf);
 
-    return true;
+    return add_assets_file_toc_entry(toc, outputFS, errMsgBuf, type, audioBeginPos);
 }
 
-static bool pack_sounds(FILE* const outputFS, char* const srcAssetFilePathBuf, zf3::AudioSample* const samples, char* const errorMsgBuf, const cJSON* const instrsCJ, const int srcAssetFilePathStartLen) {
+static bool pack_sounds(FILE* const outputFS, AssetsFileTOC& toc, char* const srcAssetFilePathBuf, zf3::AudioSample* const samples, char* const errorMsgBuf, const cJSON* const instrsCJ, const int srcAssetFilePathStartLen) {
     // Get the sounds array from the packing instructions JSON file.
     const cJSON* const cjSnds = get_cj_assets_array(instrsCJ, "sounds");
 
@@ -53,7 +55,7 @@ static bool pack_sounds(FILE* const outputFS, char* const srcAssetFilePathBuf, z
         return false;
     }
 
-    // Get, check, and write the number of sounds to pack.
+    // Get and check the number of sounds to pack.
     const int sndCnt = cJSON_GetArraySize(cjSnds);
 
     if (sndCnt > zf3::gk_soundLimit) {
@@ -61,8 +63,6 @@ static bool pack_sounds(FILE* const outputFS, char* const srcAssetFilePathBuf, z
         return false;
     }
 
-    fwrite(&sndCnt, sizeof(sndCnt), 1, outputFS);
-
     // Pack each sound.
     const cJSON* cjSndRelFilePath = nullptr;
 
@@ -76,7 +76,7 @@ static bool pack_sounds(FILE* const outputFS, char* const srcAssetFilePathBuf, z
             return false;
         }
 
-        if (!load_and_write_audio_data_from_file(outputFS, samples, errorMsgBuf, srcAssetFilePathBuf)) {
+        if (!load_and_write_audio_data_from_file(outputFS, toc, samples, errorMsgBuf, zf3::ASSET_TYPE_SOUND, srcAssetFilePathBuf)) {
             return false;
         }
 
@@ -87,7 +87,7 @@ static bool pack_sounds(FILE* const outputFS, char* const srcAssetFilePathBuf, z
 }
 
 // TODO: Rid this world of such horrid duplicity!
-static bool pack_music(FILE* const outputFS, char* const srcAssetFilePathBuf, zf3::AudioSample* const samples, char* const errorMsgBuf, const cJSON* const instrsCJ, const int srcAssetFilePathStartLen) {
+static bool pack_music(FILE* const outputFS, AssetsFileTOC& toc, char* const srcAssetFilePathBuf, zf3::AudioSample* const samples, char* const errorMsgBuf, const cJSON* const instrsCJ, const int srcAssetFilePathStartLen) {
     // Get the music array from the packing instructions JSON file.
     const cJSON* const cjMusic = get_cj_assets_array(instrsCJ, "music");
 
@@ -96,7 +96,7 @@ static bool pack_music(FILE* const outputFS, char* const srcAssetFilePathBuf, zf
         return false;
     }
 
-    // Get, check, and write the number of music tracks to pack.
+    // Get and check the number of music tracks to pack.
     const int musicCnt = cJSON_GetArraySize(cjMusic);
 
     if (musicCnt > zf3::gk_musicLimit) {
@@ -104,8 +104,6 @@ static bool pack_music(FILE* const outputFS, char* const srcAssetFilePathBuf, zf
         return false;
     }
 
-    fwrite(&musicCnt, sizeof(musicCnt), 1, outputFS);
-
     // Pack each music track.
     const cJSON* cjMusicRelFilePath = nullptr;
 
@@ -119,7 +117,7 @@ static bool pack_music(FILE* const outputFS, char* const srcAssetFilePathBuf, zf
             return false;
         }
 
-        if (!load_and_write_audio_data_from_file(outputFS, samples, errorMsgBuf, srcAssetFilePathBuf)) {
+        if (!load_and_write_audio_data_from_file(outputFS, toc, samples, errorMsgBuf, zf3::ASSET_TYPE_MUSIC, srcAssetFilePathBuf)) {
             return false;
         }
 
@@ -129,15 +127,15 @@ static bool pack_music(FILE* const outputFS, char* const srcAssetFilePathBuf, zf
     return true;
 }
 
-bool pack_audio(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
+bool pack_audio(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
     const auto samples = zf3::alloc<zf3::AudioSample>(zf3::gk_audioSamplesPerChunk);
 
     if (!samples) {
         return false;
     }
 
-    const bool success = pack_sounds(outputFS, srcAssetFilePathBuf, samples, errorMsgBuf, instrsCJ, srcAssetFilePathStartLen)
-        && pack_music(outputFS, srcAssetFilePathBuf, samples, errorMsgBuf, instrsCJ, srcAssetFilePathStartLen);
+    const bool success = pack_sounds(outputFS, toc, srcAssetFilePathBuf, samples, errorMsgBuf, instrsCJ, srcAssetFilePathStartLen)
+        && pack_music(outputFS, toc, srcAssetFilePathBuf, samples, errorMsgBuf, instrsCJ, srcAssetFilePathStartLen);
 
     free(samples);
 
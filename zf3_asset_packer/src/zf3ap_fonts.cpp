@@ -6,7 +6,7 @@
 struct FontData {
     zf3::FontArrangementInfo arrangementInfo;
     zf3::Pt2D texSize;
-    zf3::Byte texPxData[zf3::gk_texPxDataSizeLimit];
+    zf3::Byte texPxData[zf3::gk_fontTexPxDataSizeLimit];
 };
 
 static int calc_largest_bitmap_width(const FT_Face ftFace) {
@@ -63,17 +63,6 @@ static bool load_font_data(FontData& fd, const FT_Library ftLib, const char* con
         return false;
     }
 
-    // Initialise the font texture pixel data to transparent white.
-    const int texPxDataSize = zf3::gk_texChannelCnt * fd.texSize.x * fd.texSize.y;
-
-    for (int i = 0; i < texPxDataSize; i += zf3::gk_texChannelCnt) {
-        fd.texPxData[i + 0] = 255;
-        fd.texPxData[i + 1] = 255;
-        fd.texPxData[i + 2] = 255;
-        fd.texPxData[i + 3] = 0;
-    }
-    //
-
     int charDrawX = 0;
     int charDrawY = 0;
 
@@ -114,9 +103,9 @@ static bool load_font_data(FontData& fd, const FT_Library ftLib, const char* con
                 if (pxAlpha > 0) {
                     int pxX = fd.arrangementInfo.chars.srcRects[i].x + x;
                     int pxY = fd.arrangementInfo.chars.srcRects[i].y + y;
-                    int pxDataIndex = (pxY * fd.texSize.x * zf3::gk_texChannelCnt) + (pxX * zf3::gk_texChannelCnt);
+                    int pxDataIndex = (pxY * fd.texSize.x) + pxX;
 
-                    fd.texPxData[pxDataIndex + 3] = pxAlpha;
+                    fd.texPxData[pxDataIndex] = pxAlpha;
                 }
             }
         }
@@ -130,7 +119,7 @@ static bool load_font_data(FontData& fd, const FT_Library ftLib, const char* con
     return true;
 }
 
-bool pack_fonts(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
+bool pack_fonts(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
     // Initialise FreeType.
     FT_Library ftLib;
 
@@ -157,7 +146,7 @@ bool pack_fonts(FILE* const outputFS, const cJSON* const instrsCJ, char* const s
         return false;
     }
 
-    // Get, check, and write the number of fonts to pack.
+    // Get and check the number of fonts to pack.
     const int fontCnt = cJSON_GetArraySize(cjFonts);
 
     if (fontCnt > zf3::gk_fontLimit) {
@@ -167,8 +156,6 @@ bool pack_fonts(FILE* const outputFS, const cJSON* const instrsCJ, char* const s
         return false;
     }
 
-    fwrite(&fontCnt, sizeof(fontCnt), 1, outputFS);
-
     // Pack each font.
     bool success = true;
 
@@ -199,7 +186,17 @@ bool pack_fonts(FILE* const outputFS, const cJSON* const instrsCJ, char* const s
             break;
         }
 
-        fwrite(fontData, sizeof(*fontData), 1, outputFS);
+        const long fontBeginPos = ftell(outputFS);
+
+        // Write only the pixel data within the texture size, which is usually far smaller than the limit.
+        fwrite(&fontData->arrangementInfo, sizeof(fontData->arrangementInfo), 1, outputFS);
+        fwrite(&fontData->texSize, sizeof(fontData->texSize), 1, outputFS);
+        fwrite(fontData->texPxData, sizeof(*fontData->texPxData), fontData->texSize.x * fontData->texSize.y, outputFS);
+
+        if (!add_assets_file_toc_entry(toc, outputFS, errorMsgBuf, zf3::ASSET_TYPE_FONT, fontBeginPos)) {
+            success = false;
+            break;
+        }
 
         zf3::log("Packed font with file path \"%s\" and point size %d.", srcAssetFilePathBuf, cjPtSize->valueint);
     }
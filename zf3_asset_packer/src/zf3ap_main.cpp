@@ -6,6 +6,7 @@ struct AssetPacker {
     FILE* outputFS;
     char* instrsFileChars;
     cJSON* instrsCJ;
+    AssetsFileTOC toc;
 };
 
 static FILE* open_output_file(const char* const outputDir, char* const errorMsgBuf) {
@@ -70,10 +71,41 @@ static bool run_asset_packer(AssetPacker& packer, char* const errorMsgBuf, const
         return false;
     }
 
+    // Leave space for the header, which can only be completed once the table of contents has been written.
+    zf3::AssetsFileHeader header = {
+        .magic = zf3::gk_assetsFileMagic,
+        .version = zf3::gk_assetsFileVersion,
+        .tocOffs = 0, // Filled in once the table of contents has been written after the assets.
+        .tocEntryCnt = 0
+    };
+
+    fwrite(&header, sizeof(header), 1, packer.outputFS);
+
     // Perform packing for each asset type using the packing instructions file.
-    if (!pack_textures(packer.outputFS, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)
-        || !pack_fonts(packer.outputFS, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)
-        || !pack_audio(packer.outputFS, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)) {
+    if (!pack_textures(packer.outputFS, packer.toc, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)
+        || !pack_fonts(packer.outputFS, packer.toc, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)
+        || !pack_audio(packer.outputFS, packer.toc, packer.instrsCJ, srcAssetFilePathBuf, srcAssetFilePathStartLen, errorMsgBuf)) {
+        return false;
+    }
+
+    // Write the table of contents, then go back and complete the header.
+    const long tocPos = ftell(packer.outputFS);
+
+    if (tocPos < 0 || tocPos > INT_MAX - static_cast<long>(sizeof(zf3::AssetsFileTOCEntry) * packer.toc.entryCnt)) {
+        snprintf(errorMsgBuf, gk_errorMsgBufSize, "The assets file exceeds the size limit of %d bytes!", INT_MAX);
+        return false;
+    }
+
+    fwrite(packer.toc.entries, sizeof(*packer.toc.entries), packer.toc.entryCnt, packer.outputFS);
+
+    header.tocOffs = static_cast<int>(tocPos);
+    header.tocEntryCnt = packer.toc.entryCnt;
+
+    fseek(packer.outputFS, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, packer.outputFS);
+
+    if (ferror(packer.outputFS)) {
+        snprintf(errorMsgBuf, gk_errorMsgBufSize, "Failed to write to the output file!");
         return false;
     }
 
@@ -140,3 +172,26 @@ bool complete_asset_file_path(char* const srcAssetFilePathBuf, char* const error
 
     return true;
 }
+
+bool add_assets_file_toc_entry(AssetsFileTOC& toc, FILE* const outputFS, char* const errorMsgBuf, const zf3::AssetType type, const long assetBeginPos, const int flags) {
+    assert(toc.entryCnt < zf3::gk_assetsFileTOCEntryLimit);
+    assert(toc.entryCnt == 0 || toc.entries[toc.entryCnt - 1].type <= type);
+
+    const long assetEndPos = ftell(outputFS);
+
+    if (assetBeginPos < 0 || assetEndPos < assetBeginPos || assetEndPos > INT_MAX) {
+        snprintf(errorMsgBuf, gk_errorMsgBufSize, "The assets file exceeds the size limit of %d bytes!", INT_MAX);
+        return false;
+    }
+
+    toc.entries[toc.entryCnt] = {
+        .type = type,
+        .offs = static_cast<int>(assetBeginPos),
+        .size = static_cast<int>(assetEndPos - assetBeginPos),
+        .flags = flags
+    };
+
+    ++toc.entryCnt;
+
+    return true;
+}
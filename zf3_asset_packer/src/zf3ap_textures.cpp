@@ -1,6 +1,6 @@
 #include "zf3ap.h"
 
-bool pack_textures(FILE* const outputFS, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
+bool pack_textures(FILE* const outputFS, AssetsFileTOC& toc, const cJSON* const instrsCJ, char* const srcAssetFilePathBuf, const int srcAssetFilePathStartLen, char* const errorMsgBuf) {
     // Get the textures array from the packing instructions JSON file.
     const cJSON* const cjTextures = get_cj_assets_array(instrsCJ, "textures");
 
@@ -9,7 +9,7 @@ bool pack_textures(FILE* const outputFS, const cJSON* const instrsCJ, char* cons
         return false;
     }
 
-    // Get, check, and write the number of textures to pack.
+    // Get and check the number of textures to pack.
     const int texCnt = cJSON_GetArraySize(cjTextures);
 
     if (texCnt > zf3::gk_texLimit) {
@@ -17,8 +17,6 @@ bool pack_textures(FILE* const outputFS, const cJSON* const instrsCJ, char* cons
         return false;
     }
 
-    fwrite(&texCnt, sizeof(texCnt), 1, outputFS);
-
     // Pack each texture.
     const cJSON* cjTexRelFilePath = nullptr;
 
@@ -42,12 +40,28 @@ bool pack_textures(FILE* const outputFS, const cJSON* const instrsCJ, char* cons
             return false;
         }
 
+        const long texBeginPos = ftell(outputFS);
+
         fwrite(&texSize, sizeof(texSize), 1, outputFS);
         fwrite(texPxData, sizeof(*texPxData), texSize.x * texSize.y * zf3::gk_texChannelCnt, outputFS);
 
-        zf3::log("Packed texture with file path \"%s\".", srcAssetFilePathBuf);
+        // Record whether the texture is fully opaque, so that the loader does not have to check every pixel.
+        int flags = zf3::gk_texAssetOpaqueFlag;
+
+        for (int i = 3; i < texSize.x * texSize.y * zf3::gk_texChannelCnt; i += zf3::gk_texChannelCnt) {
+            if (texPxData[i] != 255) {
+                flags &= ~zf3::gk_texAssetOpaqueFlag;
+                break;
+            }
+        }
 
         stbi_image_free(texPxData);
+
+        if (!add_assets_file_toc_entry(toc, outputFS, errorMsgBuf, zf3::ASSET_TYPE_TEXTURE, texBeginPos, flags)) {
+            return false;
+        }
+
+        zf3::log("Packed texture with file path \"%s\".", srcAssetFilePathBuf);
     }
 
     return true;
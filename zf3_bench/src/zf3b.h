@@ -0,0 +1,57 @@
+#pragma once
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <zf3.h>
+
+constexpr int gk_benchTexCnt = 32;
+constexpr zf3::Pt2D gk_benchTexSize = {64, 64};
+constexpr zf3::Pt2D gk_benchFontCharSize = {8, 16};
+
+struct NullGLCallCnts {
+    int total;
+    int bufUploads; // Calls which submit data to buffer objects.
+    int draws;
+};
+
+void install_null_gl();
+void reset_null_gl_call_cnts();
+const NullGLCallCnts& get_null_gl_call_cnts();
+
+constexpr int gk_benchFrameCnt = 60;
+
+// References provided to a bench case in its frame functions.
+struct BenchFrameFuncData {
+    zf3::Renderer& renderer;
+    int frameIndex;
+    const void* caseData; // Whatever the case passed to run_bench_frames.
+};
+
+using BenchFramePrepare = void (*)(const BenchFrameFuncData& data);
+using BenchFrameBody = bool (*)(const BenchFrameFuncData& data);
+
+// Totals over every measured frame of a bench case.
+struct BenchFrameTotals {
+    double durMs;
+    NullGLCallCnts callCnts;
+    int skippedStateCallCnt;
+};
+
+zf3::Renderer* create_bench_renderer();
+void destroy_bench_renderer(zf3::Renderer* const renderer);
+bool run_bench_frames(BenchFrameTotals& totals, zf3::Renderer& renderer, const BenchFrameBody body, const void* const caseData, const BenchFramePrepare prepare = nullptr);
+void log_bench_frame_totals(const char* const caseName, const double rate, const char* const rateUnit, const BenchFrameTotals& totals, const char* const suffix = "");
+
+bool run_sprite_bench();
+bool run_text_bench();
+bool run_tilemap_bench();
+bool run_particle_bench();
+
+inline double get_bench_time_ms() {
+    const auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::milli>(time).count();
+}
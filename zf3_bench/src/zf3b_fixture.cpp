@@ -0,0 +1,70 @@
+#include "zf3b.h"
+
+// Allocates and resets a single-layer renderer for a bench case, or returns null on failure.
+zf3::Renderer* create_bench_renderer() {
+    const auto renderer = zf3::alloc_zeroed<zf3::Renderer>();
+
+    if (!renderer) {
+        zf3::log_error("Failed to allocate renderer memory!");
+        return nullptr;
+    }
+
+    if (!zf3::reset_renderer(*renderer, 1)) {
+        free(renderer);
+        return nullptr;
+    }
+
+    return renderer;
+}
+
+void destroy_bench_renderer(zf3::Renderer* const renderer) {
+    zf3::clean_renderer(*renderer);
+    free(renderer);
+}
+
+// Runs the body and then renders over gk_benchFrameCnt frames, timing both and adding up the GL calls they make. The preparation step, if given, runs untimed before each frame.
+bool run_bench_frames(BenchFrameTotals& totals, zf3::Renderer& renderer, const BenchFrameBody body, const void* const caseData, const BenchFramePrepare prepare) {
+    assert(body);
+
+    totals = {};
+
+    const zf3::ShaderProgs shaderProgs = {};
+
+    for (int i = 0; i < gk_benchFrameCnt; ++i) {
+        const BenchFrameFuncData data = {
+            .renderer = renderer,
+            .frameIndex = i,
+            .caseData = caseData
+        };
+
+        if (prepare) {
+            prepare(data);
+        }
+
+        reset_null_gl_call_cnts();
+
+        const double startTime = get_bench_time_ms();
+
+        if (!body(data)) {
+            return false;
+        }
+
+        zf3::render_all(renderer, shaderProgs);
+
+        totals.durMs += get_bench_time_ms() - startTime;
+
+        const NullGLCallCnts& callCnts = get_null_gl_call_cnts();
+        totals.callCnts.total += callCnts.total;
+        totals.callCnts.bufUploads += callCnts.bufUploads;
+        totals.callCnts.draws += callCnts.draws;
+        totals.skippedStateCallCnt += renderer.glStateCache.skippedCallCnt;
+    }
+
+    return true;
+}
+
+void log_bench_frame_totals(const char* const caseName, const double rate, const char* const rateUnit, const BenchFrameTotals& totals, const char* const suffix) {
+    zf3::log("%-24s %10.1f %-12s | GL calls/frame: %7d total, %7d uploads, %4d draws, %4d state calls skipped%s", caseName, rate, rateUnit,
+        totals.callCnts.total / gk_benchFrameCnt, totals.callCnts.bufUploads / gk_benchFrameCnt, totals.callCnts.draws / gk_benchFrameCnt, totals.skippedStateCallCnt / gk_benchFrameCnt,
+        suffix);
+}
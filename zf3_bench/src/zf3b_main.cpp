@@ -0,0 +1,144 @@
+#include "zf3b.h"
+
+// Determines where to write the bench assets file. It goes in the temporary directory under a bench-specific name, so that running the bench never touches a game's own assets file.
+static bool get_bench_assets_file_path(char* const pathBuf, const int pathBufSize) {
+    std::error_code errorCode;
+    const std::filesystem::path dir = std::filesystem::temp_directory_path(errorCode);
+
+    if (errorCode) {
+        zf3::log_error("Failed to get the temporary directory path!");
+        return false;
+    }
+
+    const std::string path = (dir / "zf3_bench_assets.zf3").string();
+
+    if (snprintf(pathBuf, pathBufSize, "%s", path.c_str()) >= pathBufSize) {
+        zf3::log_error("The bench assets file path \"%s\" is too long!", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Writes a minimal assets file, so that the framework asset loader can run against it. The layout matches that written by the asset packer.
+static bool write_bench_assets_file(const char* const filePath) {
+    FILE* const fs = fopen(filePath, "wb");
+
+    if (!fs) {
+        zf3::log_error("Failed to open \"%s\" for writing!", filePath);
+        return false;
+    }
+
+    zf3::AssetsFileHeader header = {
+        .magic = zf3::gk_assetsFileMagic,
+        .version = zf3::gk_assetsFileVersion,
+        .tocOffs = 0, // Filled in once the table of contents has been written after the assets.
+        .tocEntryCnt = 0
+    };
+
+    fwrite(&header, sizeof(header), 1, fs);
+
+    zf3::AssetsFileTOCEntry tocEntries[gk_benchTexCnt + 1];
+    int tocEntryCnt = 0;
+
+    const int texPxDataSize = zf3::gk_texChannelCnt * gk_benchTexSize.x * gk_benchTexSize.y;
+    const auto texPxData = zf3::alloc_zeroed<zf3::Byte>(texPxDataSize);
+
+    if (!texPxData) {
+        fclose(fs);
+        return false;
+    }
+
+    for (int i = 0; i < gk_benchTexCnt; ++i) {
+        tocEntries[tocEntryCnt] = {
+            .type = zf3::ASSET_TYPE_TEXTURE,
+            .offs = static_cast<int>(ftell(fs)),
+            .size = static_cast<int>(sizeof(gk_benchTexSize)) + texPxDataSize,
+            .flags = 0 // The pixels are zeroed, so fully transparent.
+        };
+
+        ++tocEntryCnt;
+
+        fwrite(&gk_benchTexSize, sizeof(gk_benchTexSize), 1, fs);
+        fwrite(texPxData, 1, texPxDataSize, fs);
+    }
+
+    free(texPxData);
+
+    // Write a monospaced font, so that text layout produces distinct glyph positions.
+    {
+        const auto fontArrangementInfo = zf3::alloc_zeroed<zf3::FontArrangementInfo>();
+        const zf3::Pt2D fontTexSize = {gk_benchFontCharSize.x * zf3::gk_fontCharRangeSize, gk_benchFontCharSize.y};
+        const int fontPxDataSize = fontTexSize.x * fontTexSize.y;
+        const auto fontPxData = zf3::alloc_zeroed<zf3::Byte>(fontPxDataSize);
+
+        if (!fontArrangementInfo || !fontPxData) {
+            free(fontArrangementInfo);
+            free(fontPxData);
+            fclose(fs);
+            return false;
+        }
+
+        fontArrangementInfo->lineHeight = gk_benchFontCharSize.y;
+
+        for (int i = 0; i < zf3::gk_fontCharRangeSize; ++i) {
+            fontArrangementInfo->chars.horAdvances[i] = gk_benchFontCharSize.x;
+            fontArrangementInfo->chars.srcRects[i] = {i * gk_benchFontCharSize.x, 0, gk_benchFontCharSize.x, gk_benchFontCharSize.y};
+        }
+
+        tocEntries[tocEntryCnt] = {
+            .type = zf3::ASSET_TYPE_FONT,
+            .offs = static_cast<int>(ftell(fs)),
+            .size = static_cast<int>(sizeof(*fontArrangementInfo) + sizeof(fontTexSize)) + fontPxDataSize,
+            .flags = 0
+        };
+
+        ++tocEntryCnt;
+
+        fwrite(fontArrangementInfo, sizeof(*fontArrangementInfo), 1, fs);
+        fwrite(&fontTexSize, sizeof(fontTexSize), 1, fs);
+        fwrite(fontPxData, 1, fontPxDataSize, fs);
+
+        free(fontArrangementInfo);
+        free(fontPxData);
+    }
+
+    // Write the table of contents, then go back and complete the header.
+    header.tocOffs = static_cast<int>(ftell(fs));
+    header.tocEntryCnt = tocEntryCnt;
+
+    fwrite(tocEntries, sizeof(*tocEntries), tocEntryCnt, fs);
+
+    fseek(fs, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fs);
+
+    fclose(fs);
+
+    return true;
+}
+
+int main() {
+    install_null_gl();
+
+    char assetsFilePath[zf3::gk_assetsFilePathBufSize];
+
+    if (!get_bench_assets_file_path(assetsFilePath, sizeof(assetsFilePath)) || !write_bench_assets_file(assetsFilePath)) {
+        return EXIT_FAILURE;
+    }
+
+    const double loadStartTime = get_bench_time_ms();
+
+    if (!zf3::load_assets(false, 0, assetsFilePath)) {
+        remove(assetsFilePath);
+        return EXIT_FAILURE;
+    }
+
+    zf3::log("Assets loaded in %.2f ms.", get_bench_time_ms() - loadStartTime);
+
+    const bool success = run_sprite_bench() && run_text_bench() && run_tilemap_bench() && run_particle_bench();
+
+    zf3::unload_assets();
+    remove(assetsFilePath);
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,239 @@
+#include "zf3b.h"
+
+// A "null driver" which stands in for the OpenGL function pointers normally loaded by GLAD, so that renderer submission costs can be measured headlessly. Buffer uploads are still copied so that their bandwidth is accounted for.
+
+static constexpr int ik_bufStorageSize = zf3::megabytes_to_bytes(4);
+
+static NullGLCallCnts i_callCnts;
+static zf3::Byte i_bufStorage[ik_bufStorageSize];
+static GLuint i_nextObjGLID = 1;
+
+static void copy_to_buf_storage(const GLintptr offs, const GLsizeiptr size, const void* const data) {
+    if (data && offs >= 0 && offs + size <= ik_bufStorageSize) {
+        memcpy(i_bufStorage + offs, data, size);
+    }
+}
+
+static void APIENTRY null_gl_gen_objs(const GLsizei cnt, GLuint* const glIDs) {
+    ++i_callCnts.total;
+
+    for (int i = 0; i < cnt; ++i) {
+        glIDs[i] = i_nextObjGLID++;
+    }
+}
+
+static void APIENTRY null_gl_delete_objs(const GLsizei cnt, const GLuint* const glIDs) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_bind_obj(const GLuint glID) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_bind_targ_obj(const GLenum targ, const GLuint glID) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_buffer_data(const GLenum targ, const GLsizeiptr size, const void* const data, const GLenum usage) {
+    ++i_callCnts.total;
+    ++i_callCnts.bufUploads;
+    copy_to_buf_storage(0, size, data);
+}
+
+static void APIENTRY null_gl_buffer_sub_data(const GLenum targ, const GLintptr offs, const GLsizeiptr size, const void* const data) {
+    ++i_callCnts.total;
+    ++i_callCnts.bufUploads;
+    copy_to_buf_storage(offs, size, data);
+}
+
+// Mapped ranges are handed out from the start of the buffer storage, which is enough for one mapping at a time.
+static void* APIENTRY null_gl_map_buffer_range(const GLenum targ, const GLintptr offs, const GLsizeiptr size, const GLbitfield access) {
+    ++i_callCnts.total;
+    ++i_callCnts.bufUploads;
+    assert(size <= ik_bufStorageSize);
+    return i_bufStorage;
+}
+
+static GLboolean APIENTRY null_gl_unmap_buffer(const GLenum targ) {
+    ++i_callCnts.total;
+    return true;
+}
+
+static GLsync APIENTRY null_gl_fence_sync(const GLenum cond, const GLbitfield flags) {
+    ++i_callCnts.total;
+    return reinterpret_cast<GLsync>(1);
+}
+
+static GLenum APIENTRY null_gl_client_wait_sync(const GLsync sync, const GLbitfield flags, const GLuint64 timeout) {
+    ++i_callCnts.total;
+    return GL_ALREADY_SIGNALED;
+}
+
+static void APIENTRY null_gl_delete_sync(const GLsync sync) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_copy_buffer_sub_data(const GLenum readTarg, const GLenum writeTarg, const GLintptr readOffs, const GLintptr writeOffs, const GLsizeiptr size) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_bind_buffer_base(const GLenum targ, const GLuint index, const GLuint glID) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_vertex_attrib_pointer(const GLuint index, const GLint size, const GLenum type, const GLboolean normalized, const GLsizei stride, const void* const ptr) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_vertex_attrib_i_pointer(const GLuint index, const GLint size, const GLenum type, const GLsizei stride, const void* const ptr) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_vertex_attrib_divisor(const GLuint index, const GLuint divisor) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_enum(const GLenum value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_bitfield(const GLbitfield value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_clear_color(const GLfloat r, const GLfloat g, const GLfloat b, const GLfloat a) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_uniform_matrix_4fv(const GLint loc, const GLsizei cnt, const GLboolean transpose, const GLfloat* const value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_uniform_fv(const GLint loc, const GLsizei cnt, const GLfloat* const value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_uniform_iv(const GLint loc, const GLsizei cnt, const GLint* const value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_uniform_1f(const GLint loc, const GLfloat value) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_draw_elements(const GLenum mode, const GLsizei cnt, const GLenum type, const void* const indices) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_draw_elements_base_vertex(const GLenum mode, const GLsizei cnt, const GLenum type, const void* const indices, const GLint baseVert) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_draw_arrays_instanced(const GLenum mode, const GLint first, const GLsizei cnt, const GLsizei instCnt) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_draw_arrays_instanced_base_instance(const GLenum mode, const GLint first, const GLsizei cnt, const GLsizei instCnt, const GLuint baseInst) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_multi_draw_elements_indirect(const GLenum mode, const GLenum type, const void* const indirect, const GLsizei drawCnt, const GLsizei stride) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_multi_draw_arrays_indirect(const GLenum mode, const void* const indirect, const GLsizei drawCnt, const GLsizei stride) {
+    ++i_callCnts.total;
+    ++i_callCnts.draws;
+}
+
+static void APIENTRY null_gl_tex_parameter_i(const GLenum targ, const GLenum name, const GLint param) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_tex_parameter_iv(const GLenum targ, const GLenum name, const GLint* const params) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_pixel_store_i(const GLenum name, const GLint param) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_tex_image_2d(const GLenum targ, const GLint level, const GLint internalFormat, const GLsizei width, const GLsizei height, const GLint border, const GLenum format, const GLenum type, const void* const pixels) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_tex_storage_2d(const GLenum targ, const GLsizei levels, const GLenum internalFormat, const GLsizei width, const GLsizei height) {
+    ++i_callCnts.total;
+}
+
+static void APIENTRY null_gl_tex_sub_image_2d(const GLenum targ, const GLint level, const GLint x, const GLint y, const GLsizei width, const GLsizei height, const GLenum format, const GLenum type, const void* const pixels) {
+    ++i_callCnts.total;
+}
+
+void install_null_gl() {
+    glad_glGenVertexArrays = null_gl_gen_objs;
+    glad_glGenBuffers = null_gl_gen_objs;
+    glad_glGenTextures = null_gl_gen_objs;
+    glad_glDeleteVertexArrays = null_gl_delete_objs;
+    glad_glDeleteBuffers = null_gl_delete_objs;
+    glad_glDeleteTextures = null_gl_delete_objs;
+
+    glad_glBindVertexArray = null_gl_bind_obj;
+    glad_glUseProgram = null_gl_bind_obj;
+    glad_glEnableVertexAttribArray = null_gl_bind_obj;
+    glad_glBindBuffer = null_gl_bind_targ_obj;
+    glad_glBindTexture = null_gl_bind_targ_obj;
+    glad_glActiveTexture = null_gl_enum;
+    glad_glEnable = null_gl_enum;
+    glad_glDisable = null_gl_enum;
+
+    glad_glBufferData = null_gl_buffer_data;
+    glad_glBufferSubData = null_gl_buffer_sub_data;
+    glad_glMapBufferRange = null_gl_map_buffer_range;
+    glad_glUnmapBuffer = null_gl_unmap_buffer;
+    glad_glCopyBufferSubData = null_gl_copy_buffer_sub_data;
+    glad_glBindBufferBase = null_gl_bind_buffer_base;
+    glad_glVertexAttribPointer = null_gl_vertex_attrib_pointer;
+    glad_glVertexAttribIPointer = null_gl_vertex_attrib_i_pointer;
+    glad_glVertexAttribDivisor = null_gl_vertex_attrib_divisor;
+
+    glad_glClearColor = null_gl_clear_color;
+    glad_glClear = null_gl_bitfield;
+
+    glad_glUniformMatrix4fv = null_gl_uniform_matrix_4fv;
+    glad_glUniform2fv = null_gl_uniform_fv;
+    glad_glUniform4fv = null_gl_uniform_fv;
+    glad_glUniform1iv = null_gl_uniform_iv;
+    glad_glUniform1f = null_gl_uniform_1f;
+
+    glad_glDrawElements = null_gl_draw_elements;
+    glad_glDrawElementsBaseVertex = null_gl_draw_elements_base_vertex;
+    glad_glDrawArraysInstanced = null_gl_draw_arrays_instanced;
+    glad_glDrawArraysInstancedBaseInstance = null_gl_draw_arrays_instanced_base_instance;
+    glad_glMultiDrawElementsIndirect = null_gl_multi_draw_elements_indirect;
+    glad_glMultiDrawArraysIndirect = null_gl_multi_draw_arrays_indirect;
+
+    glad_glFenceSync = null_gl_fence_sync;
+    glad_glClientWaitSync = null_gl_client_wait_sync;
+    glad_glDeleteSync = null_gl_delete_sync;
+
+    glad_glTexParameteri = null_gl_tex_parameter_i;
+    glad_glTexParameteriv = null_gl_tex_parameter_iv;
+    glad_glPixelStorei = null_gl_pixel_store_i;
+    glad_glTexImage2D = null_gl_tex_image_2d;
+    glad_glTexStorage2D = null_gl_tex_storage_2d;
+    glad_glTexSubImage2D = null_gl_tex_sub_image_2d;
+}
+
+void reset_null_gl_call_cnts() {
+    zf3::zero_out(i_callCnts);
+}
+
+const NullGLCallCnts& get_null_gl_call_cnts() {
+    return i_callCnts;
+}
@@ -0,0 +1,113 @@
+#include "zf3b.h"
+
+static constexpr int ik_particleCap = 50000;
+static constexpr int ik_particleLifetime = 120;
+
+struct ParticleBenchCase {
+    const char* name;
+    bool perParticleCalls; // Whether particles are written with a write_to_sprite_batch call each rather than straight from their arrays.
+    bool instanced;
+};
+
+// Tops the system up to capacity, spreading lifetimes so that a steady share despawns every frame.
+static void spawn_particles(zf3::ParticleSystem& sys, const int frameIndex) {
+    while (sys.cnt < sys.cap) {
+        const int i = sys.cnt + frameIndex;
+
+        const zf3::ParticleSpawnInfo info = {
+            .pos = {static_cast<float>(i % 1280), static_cast<float>((i / 1280) % 720)},
+            .vel = {static_cast<float>(i % 7) - 3.0f, static_cast<float>(i % 5) - 2.0f},
+            .rotVel = 0.05f,
+            .alphaVel = -0.005f,
+            .lifetime = 1 + (i % ik_particleLifetime)
+        };
+
+        zf3::spawn_particle(sys, info);
+    }
+}
+
+struct ParticleBenchCaseData {
+    const ParticleBenchCase& benchCase;
+    zf3::ParticleSystem& sys;
+    long long& particlesTotal; // Particles left to render after each update, summed over the frames.
+};
+
+static void prepare_particle_bench_frame(const BenchFrameFuncData& data) {
+    const auto& caseData = *static_cast<const ParticleBenchCaseData*>(data.caseData);
+    spawn_particles(caseData.sys, data.frameIndex);
+}
+
+static bool run_particle_bench_frame(const BenchFrameFuncData& data) {
+    const auto& caseData = *static_cast<const ParticleBenchCaseData*>(data.caseData);
+    zf3::ParticleSystem& sys = caseData.sys;
+
+    zf3::update_particle_system(sys);
+
+    zf3::empty_sprite_batches(data.renderer);
+
+    if (caseData.benchCase.perParticleCalls) {
+        for (int j = 0; j < sys.cnt; ++j) {
+            zf3::write_to_sprite_batch(data.renderer, 0, sys.texIndex, {sys.posXs[j], sys.posYs[j]}, sys.srcRect, sys.origin, sys.rots[j], sys.scale, sys.alphas[j]);
+        }
+    } else {
+        zf3::write_particle_system_to_batch(data.renderer, 0, sys);
+    }
+
+    caseData.particlesTotal += sys.cnt;
+
+    return true;
+}
+
+static bool run_particle_bench_case(const ParticleBenchCase& benchCase) {
+    zf3::Renderer* const renderer = create_bench_renderer();
+
+    if (!renderer) {
+        return false;
+    }
+
+    renderer->layers[0].instanced = benchCase.instanced;
+
+    zf3::MemArena particleArena = {};
+    zf3::ParticleSystem sys;
+
+    if (!zf3::init_mem_arena(particleArena, zf3::megabytes_to_bytes(4)) || !zf3::init_particle_system(sys, particleArena, ik_particleCap, 0, {0, 0, 8, 8})) {
+        zf3::clean_mem_arena(particleArena);
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    long long particlesTotal = 0;
+    const ParticleBenchCaseData caseData = {benchCase, sys, particlesTotal};
+    BenchFrameTotals totals;
+
+    if (!run_bench_frames(totals, *renderer, run_particle_bench_frame, &caseData, prepare_particle_bench_frame)) {
+        zf3::clean_mem_arena(particleArena);
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    log_bench_frame_totals(benchCase.name, particlesTotal / totals.durMs, "particles/ms", totals);
+
+    zf3::clean_mem_arena(particleArena);
+    destroy_bench_renderer(renderer);
+
+    return true;
+}
+
+bool run_particle_bench() {
+    const ParticleBenchCase cases[] = {
+        {"per-particle calls", true, false},
+        {"particle system", false, false},
+        {"particle system inst.", false, true}
+    };
+
+    zf3::log("Particles updated and rendered (%d particles, %d frames):", ik_particleCap, gk_benchFrameCnt);
+
+    for (const ParticleBenchCase& benchCase : cases) {
+        if (!run_particle_bench_case(benchCase)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,149 @@
+#include "zf3b.h"
+
+
+static constexpr int ik_legacySpriteVertsLen = zf3::gk_spriteQuadShaderProgVertCnt * 4;
+static constexpr int ik_spriteCntLimit = 100000;
+
+struct SpriteBenchCase {
+    const char* name;
+    int spriteCnt;
+    int texCnt; // Sprites cycle through this many textures in submission order.
+    bool legacyUploads;
+    bool instanced;
+    bool deferred;
+    bool bulk; // Whether sprites are submitted through write_sprites_to_batch in one call.
+    bool retained; // Whether sprites are written once to a retained layer rather than every frame.
+};
+
+static zf3::Vec2D get_sprite_pos(const int index) {
+    return {static_cast<float>(index % 1280), static_cast<float>((index / 1280) % 720)};
+}
+
+static bool write_sprites(zf3::Renderer& renderer, const SpriteBenchCase& benchCase) {
+    if (benchCase.bulk) {
+        static zf3::SpriteInstance l_sprites[ik_spriteCntLimit];
+
+        for (int i = 0; i < benchCase.spriteCnt; ++i) {
+            l_sprites[i] = {
+                .texIndex = i % benchCase.texCnt,
+                .pos = get_sprite_pos(i),
+                .srcRect = {0, 0, 16, 16},
+                .rot = i * 0.01f
+            };
+        }
+
+        return zf3::write_sprites_to_batch(renderer, 0, l_sprites, benchCase.spriteCnt);
+    }
+
+    float legacyVerts[ik_legacySpriteVertsLen] = {};
+
+    for (int i = 0; i < benchCase.spriteCnt; ++i) {
+        if (!zf3::write_to_sprite_batch(renderer, 0, i % benchCase.texCnt, get_sprite_pos(i), {0, 0, 16, 16}, {0.5f, 0.5f}, i * 0.01f)) {
+            return false;
+        }
+
+        if (benchCase.legacyUploads) {
+            // Reproduce the per-sprite calls made before vertex data was staged on the CPU.
+            const int slotIndex = i % zf3::gk_spriteBatchSlotLimit;
+            glBindVertexArray(1);
+            glBindBuffer(GL_ARRAY_BUFFER, 1);
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(legacyVerts) * slotIndex, sizeof(legacyVerts), legacyVerts);
+        }
+    }
+
+    return true;
+}
+
+// Fills a deferred layer to its command limit, then checks that one more sprite is turned away rather than written past the end of the commands.
+static bool check_sprite_cmd_limit(zf3::Renderer& renderer, const SpriteBenchCase& benchCase) {
+    zf3::empty_sprite_batches(renderer);
+
+    if (!write_sprites(renderer, benchCase)) {
+        return false;
+    }
+
+    if (zf3::write_to_sprite_batch(renderer, 0, 0, {}, {0, 0, 16, 16})) {
+        zf3::log_error("A sprite beyond the command limit of a deferred layer was accepted!");
+        return false;
+    }
+
+    zf3::empty_sprite_batches(renderer);
+
+    return true;
+}
+
+static bool run_sprite_bench_frame(const BenchFrameFuncData& data) {
+    const auto& benchCase = *static_cast<const SpriteBenchCase*>(data.caseData);
+
+    zf3::empty_sprite_batches(data.renderer);
+
+    if (!benchCase.retained || data.frameIndex == 0) {
+        return write_sprites(data.renderer, benchCase);
+    }
+
+    return true;
+}
+
+static bool run_sprite_bench_case(const SpriteBenchCase& benchCase) {
+    assert(benchCase.spriteCnt <= ik_spriteCntLimit);
+
+    zf3::Renderer* const renderer = create_bench_renderer();
+
+    if (!renderer) {
+        return false;
+    }
+
+    renderer->layers[0].instanced = benchCase.instanced;
+    renderer->layers[0].deferred = benchCase.deferred;
+    renderer->layers[0].retained = benchCase.retained;
+
+    BenchFrameTotals totals;
+
+    if (!run_bench_frames(totals, *renderer, run_sprite_bench_frame, &benchCase)) {
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    char uploadSizeStr[64];
+    snprintf(uploadSizeStr, sizeof(uploadSizeStr), " | %d bytes uploaded per sprite", benchCase.instanced ? static_cast<int>(sizeof(zf3::SpriteBatchInst)) : static_cast<int>(sizeof(float) * ik_legacySpriteVertsLen));
+
+    log_bench_frame_totals(benchCase.name, (static_cast<double>(benchCase.spriteCnt) * gk_benchFrameCnt) / totals.durMs, "sprites/ms", totals, uploadSizeStr);
+
+    const zf3::RenderLayerMemUsage memUsage = zf3::get_render_layer_mem_usage(*renderer, 0);
+    zf3::log("%-24s %10d KB sprite batches, %7d KB GL buffers", "", memUsage.spriteBatchBytes / 1024, memUsage.glBufBytes / 1024);
+
+    if (benchCase.deferred && benchCase.spriteCnt == zf3::gk_renderLayerSpriteCmdLimit && !check_sprite_cmd_limit(*renderer, benchCase)) {
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    destroy_bench_renderer(renderer);
+
+    return true;
+}
+
+bool run_sprite_bench() {
+    // Interleaving more textures than fit in one batch gives each batch at most a texture unit's worth of sprites unless submission is deferred and sorted, so those cases use fewer sprites to keep the undeferred one from growing thousands of nearly empty batches.
+    const SpriteBenchCase cases[] = {
+        {"per-sprite uploads", 100000, 8, true, false, false, false, false},
+        {"staged batch uploads", 100000, 8, false, false, false, false, false},
+        {"instanced", 100000, 8, false, true, false, false, false},
+        {"interleaved", 1000, gk_benchTexCnt, false, false, false, false, false},
+        {"interleaved deferred", 1000, gk_benchTexCnt, false, false, true, false, false},
+        {"deferred at cmd limit", zf3::gk_renderLayerSpriteCmdLimit, 8, false, false, true, false, false},
+        {"bulk", 100000, 1, false, false, false, true, false},
+        {"bulk instanced", 100000, 1, false, true, false, true, false},
+        {"single-texture", 100000, 1, false, false, false, false, false},
+        {"retained", 100000, 1, false, false, false, false, true}
+    };
+
+    zf3::log("Sprite submission (%d frames):", gk_benchFrameCnt);
+
+    for (const SpriteBenchCase& benchCase : cases) {
+        if (!run_sprite_bench_case(benchCase)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#include "zf3b.h"
+
+static constexpr int ik_labelCnt = 100;
+
+enum TextBenchRewrite {
+    TEXT_BENCH_REWRITE_NONE,
+    TEXT_BENCH_REWRITE_SAME, // Every label is rewritten with the text it already has.
+    TEXT_BENCH_REWRITE_COUNTER // Every label is rewritten with a score which increments, changing its last digits.
+};
+
+struct TextBenchCase {
+    const char* name;
+    bool merged;
+    TextBenchRewrite rewrite;
+};
+
+struct TextBenchCaseData {
+    const TextBenchCase& benchCase;
+    const zf3::CharBatchID* labelIDs;
+};
+
+// Moves and rewrites the labels, as a HUD might.
+static bool run_text_bench_frame(const BenchFrameFuncData& data) {
+    const auto& caseData = *static_cast<const TextBenchCaseData*>(data.caseData);
+
+    for (int j = 0; j < ik_labelCnt; ++j) {
+        zf3::get_char_batch_display_props(data.renderer, caseData.labelIDs[j]).pos.y += 1.0f;
+
+        if (caseData.benchCase.rewrite != TEXT_BENCH_REWRITE_NONE) {
+            char text[32];
+            snprintf(text, sizeof(text), "Score: %d", caseData.benchCase.rewrite == TEXT_BENCH_REWRITE_COUNTER ? 1234567 + data.frameIndex : 1234567);
+            zf3::write_to_char_batch(data.renderer, caseData.labelIDs[j], text, zf3::FONT_HOR_ALIGN_LEFT, zf3::FONT_VER_ALIGN_TOP);
+        }
+    }
+
+    return true;
+}
+
+static bool run_text_bench_case(const TextBenchCase& benchCase) {
+    zf3::Renderer* const renderer = create_bench_renderer();
+
+    if (!renderer) {
+        return false;
+    }
+
+    renderer->layers[0].charBatchesMerged = benchCase.merged;
+
+    zf3::CharBatchID labelIDs[ik_labelCnt];
+
+    for (int i = 0; i < ik_labelCnt; ++i) {
+        if (!zf3::activate_any_char_batch(*renderer, 0, 32, 0, {static_cast<float>((i % 10) * 128), static_cast<float>((i / 10) * 64)}, labelIDs[i])) {
+            destroy_bench_renderer(renderer);
+            return false;
+        }
+
+        zf3::write_to_char_batch(*renderer, labelIDs[i], "Score: 1234567", zf3::FONT_HOR_ALIGN_LEFT, zf3::FONT_VER_ALIGN_TOP);
+    }
+
+    const TextBenchCaseData caseData = {benchCase, labelIDs};
+    BenchFrameTotals totals;
+
+    if (!run_bench_frames(totals, *renderer, run_text_bench_frame, &caseData)) {
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    log_bench_frame_totals(benchCase.name, (totals.durMs * 1000.0) / gk_benchFrameCnt, "us/frame", totals);
+
+    destroy_bench_renderer(renderer);
+
+    return true;
+}
+
+bool run_text_bench() {
+    const TextBenchCase cases[] = {
+        {"per-batch draws", false, TEXT_BENCH_REWRITE_NONE},
+        {"merged per font", true, TEXT_BENCH_REWRITE_NONE},
+        {"merged, same text", true, TEXT_BENCH_REWRITE_SAME},
+        {"merged, counter text", true, TEXT_BENCH_REWRITE_COUNTER}
+    };
+
+    zf3::log("Text rendering (%d labels, %d frames):", ik_labelCnt, gk_benchFrameCnt);
+
+    for (const TextBenchCase& benchCase : cases) {
+        if (!run_text_bench_case(benchCase)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,96 @@
+#include "zf3b.h"
+
+static constexpr zf3::Pt2D ik_mapSize = {256, 256};
+static constexpr zf3::Pt2D ik_tileSize = {16, 16};
+static constexpr int ik_tilesetTileCnt = (gk_benchTexSize.x / ik_tileSize.x) * (gk_benchTexSize.y / ik_tileSize.y);
+
+struct TilemapBenchCase {
+    const char* name;
+    bool tilemap; // Whether tiles are drawn through a layer tilemap rather than written as sprites every frame.
+    int editsPerFrame;
+};
+
+static int get_bench_tile(const int x, const int y) {
+    return (x * 7 + y * 3) % ik_tilesetTileCnt;
+}
+
+static void write_tile_sprites(zf3::Renderer& renderer) {
+    for (int y = 0; y < ik_mapSize.y; ++y) {
+        for (int x = 0; x < ik_mapSize.x; ++x) {
+            const int tile = get_bench_tile(x, y);
+            const zf3::Rect srcRect = {(tile % (gk_benchTexSize.x / ik_tileSize.x)) * ik_tileSize.x, (tile / (gk_benchTexSize.x / ik_tileSize.x)) * ik_tileSize.y, ik_tileSize.x, ik_tileSize.y};
+            zf3::write_to_sprite_batch(renderer, 0, 0, {static_cast<float>(x * ik_tileSize.x), static_cast<float>(y * ik_tileSize.y)}, srcRect, {});
+        }
+    }
+}
+
+static bool run_tilemap_bench_frame(const BenchFrameFuncData& data) {
+    const auto& benchCase = *static_cast<const TilemapBenchCase*>(data.caseData);
+
+    zf3::empty_sprite_batches(data.renderer);
+
+    if (benchCase.tilemap) {
+        for (int j = 0; j < benchCase.editsPerFrame; ++j) {
+            const zf3::Pt2D tilePos = {(data.frameIndex * 37 + j * 11) % ik_mapSize.x, (data.frameIndex * 53 + j * 5) % ik_mapSize.y};
+            zf3::set_tilemap_tile(data.renderer, 0, tilePos, (data.frameIndex + j) % ik_tilesetTileCnt);
+        }
+    } else {
+        write_tile_sprites(data.renderer);
+    }
+
+    return true;
+}
+
+static bool run_tilemap_bench_case(const TilemapBenchCase& benchCase) {
+    zf3::Renderer* const renderer = create_bench_renderer();
+
+    if (!renderer) {
+        return false;
+    }
+
+    if (benchCase.tilemap) {
+        if (!zf3::init_layer_tilemap(*renderer, 0, 0, ik_mapSize, ik_tileSize)) {
+            destroy_bench_renderer(renderer);
+            return false;
+        }
+
+        for (int y = 0; y < ik_mapSize.y; ++y) {
+            for (int x = 0; x < ik_mapSize.x; ++x) {
+                zf3::set_tilemap_tile(*renderer, 0, {x, y}, get_bench_tile(x, y));
+            }
+        }
+
+        zf3::render_all(*renderer, {}); // Build the chunks up front, as a level would on load.
+    }
+
+    BenchFrameTotals totals;
+
+    if (!run_bench_frames(totals, *renderer, run_tilemap_bench_frame, &benchCase)) {
+        destroy_bench_renderer(renderer);
+        return false;
+    }
+
+    log_bench_frame_totals(benchCase.name, (totals.durMs * 1000.0) / gk_benchFrameCnt, "us/frame", totals);
+
+    destroy_bench_renderer(renderer);
+
+    return true;
+}
+
+bool run_tilemap_bench() {
+    const TilemapBenchCase cases[] = {
+        {"tiles as sprites", false, 0},
+        {"tilemap", true, 0},
+        {"tilemap, 4 edits/frame", true, 4}
+    };
+
+    zf3::log("Tilemap rendering (%dx%d tiles, %d frames):", ik_mapSize.x, ik_mapSize.y, gk_benchFrameCnt);
+
+    for (const TilemapBenchCase& benchCase : cases) {
+        if (!run_tilemap_bench_case(benchCase)) {
+            return false;
+        }
+    }
+
+    return true;
+}
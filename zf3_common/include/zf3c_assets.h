@@ -16,9 +16,40 @@ namespace zf3 {
 
     constexpr int gk_fontCharRangeBegin = 32;
     constexpr int gk_fontCharRangeSize = 95;
+    constexpr int gk_fontTexPxDataSizeLimit = gk_texSizeLimit.x * gk_texSizeLimit.y; // Font textures store only the alpha of each pixel, with the colour being white.
 
     constexpr int gk_audioSamplesPerChunk = 44100;
 
+    // The assets file begins with a header, followed by the data of each asset and then a table of contents giving the type and location of every asset. Entries in the table are grouped by asset type, with the assets of each type in index order.
+    constexpr int gk_assetsFileMagic = 'Z' | ('F' << 8) | ('3' << 16) | ('A' << 24);
+    constexpr int gk_assetsFileVersion = 2; // Must be incremented whenever the layout of the file or of any asset within it changes, so that stale files are rejected.
+    constexpr int gk_assetsFileTOCEntryLimit = gk_texLimit + gk_fontLimit + gk_soundLimit + gk_musicLimit;
+
+    constexpr int gk_texAssetOpaqueFlag = 1 << 0; // Every pixel of the texture is fully opaque.
+
+    enum AssetType {
+        ASSET_TYPE_TEXTURE,
+        ASSET_TYPE_FONT,
+        ASSET_TYPE_SOUND,
+        ASSET_TYPE_MUSIC,
+
+        ASSET_TYPE_CNT
+    };
+
+    struct AssetsFileHeader {
+        int magic;
+        int version;
+        int tocOffs;
+        int tocEntryCnt;
+    };
+
+    struct AssetsFileTOCEntry {
+        int type;
+        int offs;
+        int size;
+        int flags;
+    };
+
     using AudioSample = float;
 
     struct FontCharsArrangementInfo {
@@ -139,6 +139,13 @@ namespace zf3 {
         return value;
     }
 
+    template<typename T>
+    constexpr void swap(T& a, T& b) {
+        const T temp = a;
+        a = b;
+        b = temp;
+    }
+
     template<typename T>
     constexpr T lerp(const T& a, const T& b, const float t) {
         return a + ((b - a) * t);
@@ -38,6 +38,18 @@ namespace zf3 {
         return n && !(n & (n - 1));
     }
 
+    constexpr int ceil_to_power_of_two(const int n) {
+        assert(n > 0);
+
+        int result = 1;
+
+        while (result < n) {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
     constexpr int kilobytes_to_bytes(int kb) {
         return kb << 10;
     }
@@ -70,6 +82,18 @@ namespace zf3 {
         return static_cast<T*>(calloc(cnt, sizeof(T)));
     }
 
+    // Resizes an allocation made with alloc or alloc_zeroed, zeroing any elements added. If nullptr is returned the original allocation is left as it was.
+    template<typename T>
+    T* realloc_zeroed(T* const ptr, const int oldCnt, const int newCnt) {
+        const auto newPtr = static_cast<T*>(realloc(ptr, sizeof(T) * newCnt));
+
+        if (newPtr && newCnt > oldCnt) {
+            memset(newPtr + oldCnt, 0, sizeof(T) * (newCnt - oldCnt));
+        }
+
+        return newPtr;
+    }
+
     template<typename T>
     void zero_out(T& data) {
         memset(&data, 0, sizeof(data));
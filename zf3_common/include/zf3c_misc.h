@@ -7,4 +7,6 @@
 
 namespace zf3 {
     char* get_file_contents(const char* const filename);
+    unsigned int hash_bytes(const void* const bytes, const int cnt, unsigned int hash = 2166136261u);
+    unsigned long long hash_bytes_64(const void* const bytes, const int cnt, unsigned long long hash = 14695981039346656037ull);
 }
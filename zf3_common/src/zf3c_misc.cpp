@@ -31,4 +31,24 @@ namespace zf3 {
 
         return contents;
     }
+
+    // FNV-1a, continued from the given hash.
+    unsigned int hash_bytes(const void* const bytes, const int cnt, unsigned int hash) {
+        for (int i = 0; i < cnt; ++i) {
+            hash ^= static_cast<const Byte*>(bytes)[i];
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    // 64-bit FNV-1a, for where collisions would go unnoticed.
+    unsigned long long hash_bytes_64(const void* const bytes, const int cnt, unsigned long long hash) {
+        for (int i = 0; i < cnt; ++i) {
+            hash ^= static_cast<const Byte*>(bytes)[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
 }